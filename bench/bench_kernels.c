@@ -0,0 +1,516 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "eeprom.h"
+#include "eeprom_map.h"
+#include "ir/ir.h"
+#include "ir/compression.h"
+#include "checksum.h"
+
+/// @file bench/bench_kernels.c
+
+/*
+ *  Cost of the IR path kernels per byte.
+ *
+ *  Times `pw_decompress_data()`, `pw_ir_checksum_seeded()`,
+ *  `pw_ir_checksum()` and `pw_eeprom_checksum()`, and the checksums on
+ *  each of the sum kernels in checksum.h, over a corpus of walker
+ *  payloads: sprites, text images, route info and team data. Each is cut
+ *  into 128-byte pages as the game sends them, and checksummed both raw
+ *  and compressed. The byte-at-a-time reference versions of the
+ *  checksums are timed alongside, and every result is checked against
+ *  them, so an optimised kernel shows up as a faster row next to its
+ *  reference or as a mismatch.
+ *
+ *  Pass a real eeprom dump with -e for real data. Without one the corpus
+ *  is drawn: blob sprites, blocky text, sparse structs.
+ *
+ *  Cycles per byte are counted with the TSC on x86. Pass the clock in MHz
+ *  with -c to have them worked out from the time instead, which is the
+ *  only way elsewhere.
+ *
+ *  usage: picowalker-bench-kernels [-e eeprom.bin] [-c mhz] [-t ms]
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define PAGE        128
+#define MAX_LEN     1536
+#define MAX_PAGES   (MAX_LEN/PAGE)
+
+typedef struct {
+    const char *name;
+    eeprom_addr_t addr;
+    uint16_t len;
+    uint8_t kind;
+} corpus_src_t;
+
+enum {
+    KIND_SPRITE,
+    KIND_TEXT,
+    KIND_STRUCT,
+};
+
+static const corpus_src_t sources[] = {
+    {"sprite small", PW_EEPROM_ADDR_IMG_POKEMON_SMALL_ANIMATED, PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED, KIND_SPRITE},
+    {"sprite large", PW_EEPROM_ADDR_IMG_POKEMON_LARGE_ANIMATED, PW_EEPROM_SIZE_IMG_POKEMON_LARGE_ANIMATED, KIND_SPRITE},
+    {"text name", PW_EEPROM_ADDR_TEXT_POKEMON_NAME, PW_EEPROM_SIZE_TEXT_POKEMON_NAME, KIND_TEXT},
+    {"text route", PW_EEPROM_ADDR_TEXT_ROUTE_NAME, PW_EEPROM_SIZE_TEXT_ROUTE_NAME, KIND_TEXT},
+    {"route info", PW_EEPROM_ADDR_ROUTE_INFO, PW_EEPROM_SIZE_ROUTE_INFO, KIND_STRUCT},
+    {"team data", PW_EEPROM_ADDR_TEAM_DATA_STRUCT, 548, KIND_STRUCT},
+};
+#define N_SOURCES   (sizeof(sources)/sizeof(sources[0]))
+
+typedef struct {
+    const corpus_src_t *src;
+    uint8_t raw[MAX_LEN];
+    size_t len;
+
+    // one write packet per page, as raw and (where it pays) compressed
+    size_t n_pages;
+    pw_packet_t raw_pk[MAX_PAGES];
+    size_t raw_pk_len[MAX_PAGES];
+    pw_packet_t cmp_pk[MAX_PAGES];
+    size_t cmp_pk_len[MAX_PAGES];   // 0 if the page doesn't compress
+    size_t cmp_bytes, cmp_out_bytes;
+} corpus_t;
+
+static corpus_t corpus[N_SOURCES];
+
+/*
+ *  ==================================================================================
+ *  Reference kernels, byte at a time, as first written
+ *  ==================================================================================
+ */
+
+static uint16_t ref_ir_checksum_seeded(const uint8_t *data, size_t len, uint16_t seed) {
+    uint32_t crc = seed;
+    for(size_t i = 0; i < len; i++) {
+        uint16_t v = data[i];
+        if(!(i&1)) v <<= 8;
+        crc += v;
+    }
+    while(crc>>16) crc = (uint16_t)crc + (crc>>16);
+    return crc;
+}
+
+static uint16_t ref_ir_checksum(pw_packet_t *packet, size_t len) {
+    uint16_t orig = packet->le_checksum;
+    packet->le_checksum = 0;
+    uint16_t crc = ref_ir_checksum_seeded(packet->bytes, 8, 0x0002);
+    if(len > 8) crc = ref_ir_checksum_seeded(packet->bytes+8, len-8, crc);
+    packet->le_checksum = orig;
+    return crc;
+}
+
+static uint8_t ref_eeprom_checksum(const uint8_t *buf, size_t len) {
+    uint8_t chk = 1;
+    for(size_t i = 0; i < len; i++) chk += buf[i];
+    return chk;
+}
+
+/*
+ *  ==================================================================================
+ *  Corpus
+ *  ==================================================================================
+ */
+
+static uint32_t rng = 0x2545f491;
+
+static uint32_t next_rand() {
+    rng ^= rng<<13;
+    rng ^= rng>>17;
+    rng ^= rng<<5;
+    return rng;
+}
+
+/*
+ *  2bpp strips of 8 rows, two bytes (low, high plane) per column.
+ */
+static void put_pixel(uint8_t *img, size_t w, size_t x, size_t y, uint8_t c) {
+    size_t idx = 2*((y/8)*w + x);
+    uint8_t bit = 1u<<(y%8);
+    img[idx+0] = (img[idx+0] & ~bit) | ((c&1)?bit:0);
+    img[idx+1] = (img[idx+1] & ~bit) | ((c&2)?bit:0);
+}
+
+static void draw_sprite(uint8_t *img, size_t len) {
+    size_t w = (len == PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED)?32:64;
+    size_t frame = len/2;           // two frames
+    size_t h = frame/(2*w)*8;
+
+    memset(img, 0, len);
+    for(size_t f = 0; f < 2; f++) {
+        int cx = w/2, cy = h/2 + (int)f, rx = w/3, ry = h/3;
+        for(size_t y = 0; y < h; y++) {
+            for(size_t x = 0; x < w; x++) {
+                int dx = (int)x-cx, dy = (int)y-cy;
+                int d = dx*dx*ry*ry + dy*dy*rx*rx, r = rx*rx*ry*ry;
+                uint8_t c = 0;
+                if(d <= r) c = (d > r*3/4)?3:((dy < 0)?1:2);
+                if(c && next_rand()%16 == 0) c = 3;
+                put_pixel(&img[f*frame], w, x, y, c);
+            }
+        }
+    }
+}
+
+static void draw_text(uint8_t *img, size_t len) {
+    size_t w = 80;
+
+    memset(img, 0, len);
+    for(size_t x = 0; x+6 < w*2/3; x += 7) {
+        uint32_t glyph = next_rand();
+        for(size_t gx = 0; gx < 5; gx++)
+            for(size_t gy = 0; gy < 7; gy++)
+                if(glyph & (1u<<((gx*7+gy)%32)))
+                    put_pixel(img, w, x+gx, 4+gy, 3);
+    }
+}
+
+static void draw_struct(uint8_t *buf, size_t len) {
+    // ids, small counters and short strings among zeros
+    memset(buf, 0, len);
+    for(size_t i = 0; i+56 <= len; i += 56) {
+        buf[i+0] = next_rand()%250;
+        buf[i+1] = next_rand()%2;
+        buf[i+2] = next_rand()%100;
+        for(size_t m = 0; m < 4; m++) buf[i+4+2*m] = next_rand();
+        for(size_t n = 0; n < 10; n++) buf[i+16+2*n] = (n < 6)?(0x2b+next_rand()%26):0xff;
+        buf[i+40] = next_rand()%100;
+    }
+}
+
+static void corpus_build(bool real) {
+    for(size_t i = 0; i < N_SOURCES; i++) {
+        corpus_t *c = &corpus[i];
+        c->src = &sources[i];
+        c->len = sources[i].len;
+
+        memcpy(c->raw, &pw_host_eeprom[sources[i].addr], c->len);
+        if(!real) {
+            switch(sources[i].kind) {
+            case KIND_SPRITE:
+                draw_sprite(c->raw, c->len);
+                break;
+            case KIND_TEXT:
+                draw_text(c->raw, c->len);
+                break;
+            case KIND_STRUCT:
+                if(sources[i].addr != PW_EEPROM_ADDR_ROUTE_INFO) draw_struct(c->raw, c->len);
+                break;
+            }
+        }
+
+        c->n_pages = (c->len+PAGE-1)/PAGE;
+        for(size_t p = 0; p < c->n_pages; p++) {
+            size_t n = c->len - p*PAGE;
+            if(n > PAGE) n = PAGE;
+
+            pw_packet_t *r = &c->raw_pk[p];
+            memset(r, 0, sizeof(*r));
+            r->cmd = CMD_EEPROM_WRITE_RAW_00;
+            memcpy(r->payload, &c->raw[p*PAGE], n);
+            c->raw_pk_len[p] = 8+PAGE;
+
+            // only whole pages are sent compressed
+            pw_packet_t *k = &c->cmp_pk[p];
+            memset(k, 0, sizeof(*k));
+            k->cmd = CMD_EEPROM_WRITE_CMP_00;
+            size_t kn = (n == PAGE)?pw_compress_data(&c->raw[p*PAGE], k->payload, PAGE, PAGE-1, PW_COMPRESS_BEST):0;
+            c->cmp_pk_len[p] = kn?8+kn:0;
+            if(kn) {
+                c->cmp_bytes += kn;
+                c->cmp_out_bytes += PAGE;
+            }
+        }
+    }
+}
+
+/*
+ *  ==================================================================================
+ *  Kernels over one corpus entry. Each returns something derived from
+ *  every result so none of the work can be left out.
+ *  ==================================================================================
+ */
+
+typedef uint32_t (*kernel_run_t)(corpus_t *c);
+typedef size_t (*kernel_bytes_t)(corpus_t *c);
+
+static uint32_t run_decompress(corpus_t *c) {
+    uint8_t out[PAGE];
+    uint32_t acc = 0;
+    for(size_t p = 0; p < c->n_pages; p++) {
+        if(!c->cmp_pk_len[p]) continue;
+        acc += pw_decompress_data(c->cmp_pk[p].payload, out, c->cmp_pk_len[p]-8);
+        acc += out[p%PAGE];
+    }
+    return acc;
+}
+
+static uint32_t run_ir_seeded(corpus_t *c) {
+    return pw_ir_checksum_seeded(c->raw, c->len, 0x0002);
+}
+
+static uint32_t run_ref_ir_seeded(corpus_t *c) {
+    return ref_ir_checksum_seeded(c->raw, c->len, 0x0002);
+}
+
+static uint32_t run_ir_raw(corpus_t *c) {
+    uint32_t acc = 0;
+    for(size_t p = 0; p < c->n_pages; p++) acc += pw_ir_checksum(&c->raw_pk[p], c->raw_pk_len[p]);
+    return acc;
+}
+
+static uint32_t run_ref_ir_raw(corpus_t *c) {
+    uint32_t acc = 0;
+    for(size_t p = 0; p < c->n_pages; p++) acc += ref_ir_checksum(&c->raw_pk[p], c->raw_pk_len[p]);
+    return acc;
+}
+
+static uint32_t run_ir_cmp(corpus_t *c) {
+    uint32_t acc = 0;
+    for(size_t p = 0; p < c->n_pages; p++)
+        if(c->cmp_pk_len[p]) acc += pw_ir_checksum(&c->cmp_pk[p], c->cmp_pk_len[p]);
+    return acc;
+}
+
+static uint32_t run_ref_ir_cmp(corpus_t *c) {
+    uint32_t acc = 0;
+    for(size_t p = 0; p < c->n_pages; p++)
+        if(c->cmp_pk_len[p]) acc += ref_ir_checksum(&c->cmp_pk[p], c->cmp_pk_len[p]);
+    return acc;
+}
+
+/*
+ *  The checksums on top of one particular sum kernel, see checksum.h
+ */
+typedef void (*sum_fn_t)(const uint8_t *data, size_t len, pw_sum_t *s);
+
+static uint32_t ir_seeded_with(sum_fn_t fn, corpus_t *c) {
+    pw_sum_t s;
+    fn(c->raw, c->len, &s);
+    uint32_t crc = 0x0002 + (s.even<<8) + s.odd;
+    while(crc>>16) crc = (uint16_t)crc + (crc>>16);
+    return crc;
+}
+
+static uint32_t eeprom_with(sum_fn_t fn, corpus_t *c) {
+    pw_sum_t s;
+    fn(c->raw, c->len, &s);
+    return (uint8_t)(1 + s.even + s.odd);
+}
+
+static uint32_t run_ir_seeded_words(corpus_t *c) {
+    return ir_seeded_with(pw_checksum_sum_words, c);
+}
+
+static uint32_t run_eeprom_words(corpus_t *c) {
+    return eeprom_with(pw_checksum_sum_words, c);
+}
+
+#ifdef PW_CHECKSUM_SSE2
+static uint32_t run_ir_seeded_sse2(corpus_t *c) {
+    return ir_seeded_with(pw_checksum_sum_sse2, c);
+}
+
+static uint32_t run_eeprom_sse2(corpus_t *c) {
+    return eeprom_with(pw_checksum_sum_sse2, c);
+}
+#endif
+
+static uint32_t run_eeprom(corpus_t *c) {
+    return pw_eeprom_checksum(c->raw, c->len);
+}
+
+static uint32_t run_ref_eeprom(corpus_t *c) {
+    return ref_eeprom_checksum(c->raw, c->len);
+}
+
+static size_t bytes_raw(corpus_t *c) {
+    return c->len;
+}
+
+static size_t bytes_raw_pk(corpus_t *c) {
+    size_t n = 0;
+    for(size_t p = 0; p < c->n_pages; p++) n += c->raw_pk_len[p];
+    return n;
+}
+
+static size_t bytes_cmp_pk(corpus_t *c) {
+    size_t n = 0;
+    for(size_t p = 0; p < c->n_pages; p++) n += c->cmp_pk_len[p];
+    return n;
+}
+
+static size_t bytes_cmp_out(corpus_t *c) {
+    return c->cmp_out_bytes;
+}
+
+typedef struct {
+    const char *name;
+    const char *form;
+    kernel_run_t run;
+    kernel_run_t ref;       // must give the same result, 0 if none
+    kernel_bytes_t bytes;
+} kernel_t;
+
+static const kernel_t kernels[] = {
+    {"decompress_data", "cmp", run_decompress, 0, bytes_cmp_out},
+    {"ir_checksum_seeded", "raw", run_ir_seeded, run_ref_ir_seeded, bytes_raw},
+    {"  words (m0+)", "raw", run_ir_seeded_words, run_ref_ir_seeded, bytes_raw},
+#ifdef PW_CHECKSUM_SSE2
+    {"  sse2", "raw", run_ir_seeded_sse2, run_ref_ir_seeded, bytes_raw},
+#endif
+    {"  reference", "raw", run_ref_ir_seeded, 0, bytes_raw},
+    {"ir_checksum", "raw", run_ir_raw, run_ref_ir_raw, bytes_raw_pk},
+    {"  reference", "raw", run_ref_ir_raw, 0, bytes_raw_pk},
+    {"ir_checksum", "cmp", run_ir_cmp, run_ref_ir_cmp, bytes_cmp_pk},
+    {"  reference", "cmp", run_ref_ir_cmp, 0, bytes_cmp_pk},
+    {"eeprom_checksum", "raw", run_eeprom, run_ref_eeprom, bytes_raw},
+    {"  words (m0+)", "raw", run_eeprom_words, run_ref_eeprom, bytes_raw},
+#ifdef PW_CHECKSUM_SSE2
+    {"  sse2", "raw", run_eeprom_sse2, run_ref_eeprom, bytes_raw},
+#endif
+    {"  reference", "raw", run_ref_eeprom, 0, bytes_raw},
+};
+#define N_KERNELS   (sizeof(kernels)/sizeof(kernels[0]))
+
+/*
+ *  ==================================================================================
+ *  Timing
+ *  ==================================================================================
+ */
+
+static volatile uint32_t sink;
+
+static uint64_t cycles_now() {
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+typedef struct {
+    double ns;
+    double cycles;
+} timing_t;
+
+/*
+ *  Best of 5 runs, each repeating the kernel for about `run_ms`.
+ *  Returns the cost of one call.
+ */
+static timing_t time_kernel(kernel_run_t run, corpus_t *c, uint32_t run_ms) {
+    uint64_t reps = 1;
+    timing_t best = {0, 0};
+
+    // find a repeat count that takes long enough to time
+    while(true) {
+        uint64_t t0 = pw_host_wall_ns();
+        for(uint64_t i = 0; i < reps; i++) sink += run(c);
+        if(pw_host_wall_ns() - t0 >= (uint64_t)run_ms*1000000/4 || reps >= (1ull<<32)) break;
+        reps *= 2;
+    }
+    reps *= 4;
+
+    for(int r = 0; r < 5; r++) {
+        uint64_t c0 = cycles_now(), t0 = pw_host_wall_ns();
+        for(uint64_t i = 0; i < reps; i++) sink += run(c);
+        uint64_t t = pw_host_wall_ns() - t0, cyc = cycles_now() - c0;
+
+        double ns = (double)t/reps;
+        if(r == 0 || ns < best.ns) {
+            best.ns = ns;
+            best.cycles = (double)cyc/reps;
+        }
+    }
+
+    return best;
+}
+
+int main(int argc, char **argv) {
+    const char *eeprom_in = 0;
+    double clock_mhz = 0;
+    uint32_t run_ms = 20;
+
+    for(int i = 1; i+1 < argc; i += 2) {
+        switch(argv[i][1]) {
+        case 'e':
+            eeprom_in = argv[i+1];
+            break;
+        case 'c':
+            clock_mhz = strtod(argv[i+1], 0);
+            break;
+        case 't':
+            run_ms = strtoul(argv[i+1], 0, 0);
+            break;
+        default:
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if(eeprom_in) {
+        if(pw_host_eeprom_load(eeprom_in) != 0) {
+            fprintf(stderr, "could not load eeprom image %s\n", eeprom_in);
+            return 1;
+        }
+    } else {
+        pw_host_eeprom_synthesise(0);
+    }
+    corpus_build(eeprom_in != 0);
+
+    printf("corpus: %s\n", eeprom_in?eeprom_in:"drawn (pass -e for a real eeprom dump)");
+    for(size_t i = 0; i < N_SOURCES; i++) {
+        corpus_t *c = &corpus[i];
+        printf("  %-13s %5zu bytes, %zu pages, compressed %zu -> %zu bytes\n",
+               c->src->name, c->len, c->n_pages, c->cmp_out_bytes, c->cmp_bytes);
+    }
+    if(clock_mhz > 0) {
+        printf("cycles: from time at %.0f MHz\n", clock_mhz);
+    } else {
+#ifdef HAVE_TSC
+        printf("cycles: TSC ticks\n");
+#endif
+    }
+    printf("\n%-19s %-4s %-13s %7s %8s %8s %9s\n",
+           "kernel", "form", "corpus", "bytes", "ns/B", "cyc/B", "MB/s");
+
+    int mismatches = 0;
+
+    for(size_t k = 0; k < N_KERNELS; k++) {
+        const kernel_t *kn = &kernels[k];
+
+        for(size_t i = 0; i < N_SOURCES; i++) {
+            corpus_t *c = &corpus[i];
+            size_t bytes = kn->bytes(c);
+            if(bytes == 0) continue;
+
+            if(kn->ref && kn->run(c) != kn->ref(c)) {
+                printf("%-19s %-4s %-13s MISMATCH against the reference\n", kn->name, kn->form, c->src->name);
+                mismatches++;
+                continue;
+            }
+
+            timing_t t = time_kernel(kn->run, c, run_ms);
+            double cyc = (clock_mhz > 0)?t.ns*clock_mhz/1000:t.cycles;
+            char cyc_s[16] = "-";
+            if(cyc > 0) snprintf(cyc_s, sizeof(cyc_s), "%.2f", cyc/bytes);
+
+            printf("%-19s %-4s %-13s %7zu %8.3f %8s %9.1f\n",
+                   kn->name, kn->form, c->src->name, bytes,
+                   t.ns/bytes, cyc_s, bytes/t.ns*1e3);
+        }
+    }
+
+    return mismatches?1:0;
+}
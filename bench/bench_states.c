@@ -0,0 +1,133 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host.h"
+#include "picowalker.h"
+#include "states.h"
+#include "screen.h"
+#include "timer.h"
+
+/// @file bench/bench_states.c
+
+/*
+ *  Per-state frame cost.
+ *
+ *  For every entry in STATE_FUNCS, run init + draw_init once, then
+ *  `n` frames of loop + draw_update, as walker_loop() would when the
+ *  redraw timer fires every frame. State transitions requested by a
+ *  state are ignored so we keep measuring the same one.
+ *
+ *  usage: picowalker-bench-states [-n frames] [-e eeprom.bin]
+ */
+
+typedef struct {
+    uint64_t wall_ns;
+    uint64_t virt_us;
+    pw_host_stats_t stats;
+} sample_t;
+
+static uint64_t virt_start, wall_start;
+
+static void sample_begin() {
+    pw_host_stats_reset();
+    virt_start = pw_now_us();
+    wall_start = pw_host_wall_ns();
+}
+
+static sample_t sample_end() {
+    sample_t s;
+    s.wall_ns = pw_host_wall_ns() - wall_start;
+    s.virt_us = pw_now_us() - virt_start;
+    s.stats = pw_host_stats;
+    return s;
+}
+
+static void print_row(const char *name, const char *phase, sample_t *s, uint32_t div) {
+    double d = div?div:1;
+    printf("%-18s %-6s %10.2f %10.1f %9.1f %8.1f %7.2f %9.1f\n",
+           name, phase,
+           s->wall_ns/1e3/d,
+           s->virt_us/d,
+           s->stats.eeprom_bytes_read/d,
+           s->stats.eeprom_reads/d,
+           s->stats.screen_draw_calls/d,
+           s->stats.screen_pixels/d
+          );
+}
+
+int main(int argc, char **argv) {
+    uint32_t n_frames = 200;
+    const char *eeprom_in = 0;
+
+    for(int i = 1; i+1 < argc; i += 2) {
+        switch(argv[i][1]) {
+        case 'n':
+            n_frames = strtoul(argv[i+1], 0, 0);
+            break;
+        case 'e':
+            eeprom_in = argv[i+1];
+            break;
+        default:
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if(eeprom_in) {
+        if(pw_host_eeprom_load(eeprom_in) != 0) {
+            fprintf(stderr, "could not load eeprom image %s\n", eeprom_in);
+            return 1;
+        }
+    } else {
+        pw_host_eeprom_synthesise(0);
+    }
+
+    walker_setup();
+
+    printf("%u frames per state, costs per frame (init row is one-off)\n", n_frames);
+    printf("%-18s %-6s %10s %10s %9s %8s %7s %9s\n",
+           "state", "phase", "wall_us", "bus_us", "ee_bytes", "ee_txn", "draws", "pixels");
+
+    for(pw_state_id_t sid = 0; sid < N_STATES; sid++) {
+        const state_funcs_t *f = &STATE_FUNCS[sid];
+        if(!f->init || !f->loop || !f->draw_init || !f->draw_update) continue;
+
+        const char *name = state_strings[sid]?state_strings[sid]:"?";
+        char fallback[16];
+        if(!state_strings[sid]) {
+            snprintf(fallback, sizeof(fallback), "state %d", sid);
+            name = fallback;
+        }
+
+        pw_state_t s = {0}, p = {0};
+        screen_flags_t sf = {0};
+        s.sid = sid;
+        p.sid = sid;
+
+        sample_begin();
+        pw_screen_clear();
+        f->init(&s, &sf);
+        f->draw_init(&s, &sf);
+        pw_screen_flush();
+        sample_t init = sample_end();
+
+        sample_begin();
+        for(uint32_t i = 0; i < n_frames; i++) {
+            f->loop(&s, &p, &sf);
+            p.sid = sid;
+            f->draw_update(&s, &sf);
+            pw_screen_flush();
+            sf.frame = (sf.frame+1)%4;
+        }
+        sample_t frames = sample_end();
+
+        f->deinit(&s, &sf);
+
+        print_row(name, "init", &init, 1);
+        print_row(name, "frame", &frames, n_frames);
+    }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#ifndef PW_HOST_H
+#define PW_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/// @file host/host.h
+
+/*
+ *  In-memory stand-in drivers so the core can be run and profiled
+ *  on a normal machine. Nothing in here is used on real hardware.
+ *
+ *  Time is virtual: `pw_now_us()` only moves when the host advances
+ *  the clock, when a driver call models bus time, or when the core
+ *  asks for a delay. This keeps runs deterministic.
+ */
+
+#define PW_HOST_EEPROM_SIZE     0x10000
+
+/*
+ *  Rough bus cost model, charged to the virtual clock.
+ *  I2C EEPROM @ 400kHz, SPI LCD @ 8MHz, IR @ 115200 baud.
+ */
+#define PW_HOST_EEPROM_TXN_US       70      // start + device/address bytes
+#define PW_HOST_EEPROM_BYTE_US      23      // 9 bits @ 400kHz
+#define PW_HOST_EEPROM_PAGE_SIZE    128
+#define PW_HOST_EEPROM_WRITE_US     5000    // write cycle per page touched
+#define PW_HOST_SCREEN_CALL_US      10
+#define PW_HOST_SCREEN_PIXEL_NS     250     // 2 bits @ 8MHz
+#define PW_HOST_IR_BYTE_US          87      // 10 bits @ 115200
+
+typedef struct {
+    uint32_t eeprom_reads;
+    uint32_t eeprom_writes;
+    uint32_t eeprom_sets;
+    uint64_t eeprom_bytes_read;
+    uint64_t eeprom_bytes_written;
+    uint64_t eeprom_bytes_set;
+    uint32_t screen_draw_calls;
+    uint64_t screen_pixels;
+    uint32_t ir_reads;
+    uint32_t ir_writes;
+    uint64_t ir_bytes_read;
+    uint64_t ir_bytes_written;
+    uint32_t audio_sounds;
+} pw_host_stats_t;
+
+/*
+ *  Called for every packet the core writes out over IR.
+ *  `data` is as it appears on the wire (still xor'd with 0xaa).
+ *  A responder can queue a reply with `pw_host_ir_push_rx()`.
+ */
+typedef void (*pw_host_ir_responder_t)(const uint8_t *data, size_t len, void *ctx);
+
+extern pw_host_stats_t pw_host_stats;
+extern uint8_t pw_host_eeprom[];
+extern uint8_t pw_host_screen[];    // SCREEN_WIDTH*SCREEN_HEIGHT, one colour per byte
+
+void pw_host_stats_reset();
+
+void pw_host_clock_advance_us(uint64_t us);
+uint64_t pw_host_wall_ns();
+
+void pw_host_eeprom_fill(uint8_t v);
+void pw_host_eeprom_synthesise(uint32_t seed);
+int  pw_host_eeprom_load(const char *path);
+int  pw_host_eeprom_save(const char *path);
+
+int  pw_host_screen_save_pgm(const char *path);
+
+void pw_host_ir_push_rx(const uint8_t *data, size_t len);
+void pw_host_ir_clear();
+size_t pw_host_ir_pending();
+void pw_host_ir_set_responder(pw_host_ir_responder_t f, void *ctx);
+
+void pw_host_accel_set_steps(uint32_t steps_per_sample);
+void pw_host_press(uint8_t b);
+
+#endif /* PW_HOST_H */
@@ -0,0 +1,150 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "eeprom.h"
+#include "eeprom_map.h"
+#include "types.h"
+#include "utils.h"
+
+/// @file host/host_eeprom.c
+
+uint8_t pw_host_eeprom[PW_HOST_EEPROM_SIZE];
+
+static uint64_t eeprom_write_cost_us(eeprom_addr_t addr, size_t len) {
+    if(len == 0) return 0;
+    size_t first = addr/PW_HOST_EEPROM_PAGE_SIZE;
+    size_t last  = (addr+len-1)/PW_HOST_EEPROM_PAGE_SIZE;
+    return PW_HOST_EEPROM_TXN_US + len*PW_HOST_EEPROM_BYTE_US + (last-first+1)*PW_HOST_EEPROM_WRITE_US;
+}
+
+/*
+ *  Clamp accesses to the end of the chip rather than wrapping,
+ *  the core should never do either.
+ */
+static size_t eeprom_clamp(eeprom_addr_t addr, size_t len) {
+    if((size_t)addr + len > PW_HOST_EEPROM_SIZE) {
+        printf("[host] eeprom access out of range: %04x+%zu\n", addr, len);
+        return PW_HOST_EEPROM_SIZE - addr;
+    }
+    return len;
+}
+
+void pw_eeprom_init() {
+}
+
+int pw_eeprom_read(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    len = eeprom_clamp(addr, len);
+    memcpy(buf, pw_host_eeprom+addr, len);
+
+    pw_host_stats.eeprom_reads++;
+    pw_host_stats.eeprom_bytes_read += len;
+    pw_host_clock_advance_us(PW_HOST_EEPROM_TXN_US + len*PW_HOST_EEPROM_BYTE_US);
+    return (int)len;
+}
+
+int pw_eeprom_write(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    len = eeprom_clamp(addr, len);
+    memcpy(pw_host_eeprom+addr, buf, len);
+
+    pw_host_stats.eeprom_writes++;
+    pw_host_stats.eeprom_bytes_written += len;
+    pw_host_clock_advance_us(eeprom_write_cost_us(addr, len));
+    return (int)len;
+}
+
+void pw_eeprom_set_area(eeprom_addr_t addr, uint8_t v, size_t len) {
+    len = eeprom_clamp(addr, len);
+    memset(pw_host_eeprom+addr, v, len);
+
+    pw_host_stats.eeprom_sets++;
+    pw_host_stats.eeprom_bytes_set += len;
+    pw_host_clock_advance_us(eeprom_write_cost_us(addr, len));
+}
+
+
+void pw_host_eeprom_fill(uint8_t v) {
+    memset(pw_host_eeprom, v, PW_HOST_EEPROM_SIZE);
+}
+
+int pw_host_eeprom_load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if(!f) return -1;
+    size_t n = fread(pw_host_eeprom, 1, PW_HOST_EEPROM_SIZE, f);
+    fclose(f);
+    return (n == PW_HOST_EEPROM_SIZE)?0:-1;
+}
+
+int pw_host_eeprom_save(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if(!f) return -1;
+    size_t n = fwrite(pw_host_eeprom, 1, PW_HOST_EEPROM_SIZE, f);
+    fclose(f);
+    return (n == PW_HOST_EEPROM_SIZE)?0:-1;
+}
+
+static void put_reliable(eeprom_addr_t addr1, eeprom_addr_t addr2, void *data, size_t len) {
+    uint8_t chk = pw_eeprom_checksum(data, len);
+    memcpy(pw_host_eeprom+addr1, data, len);
+    pw_host_eeprom[addr1+len] = chk;
+    memcpy(pw_host_eeprom+addr2, data, len);
+    pw_host_eeprom[addr2+len] = chk;
+}
+
+/*
+ *  Build a plausible, mid-walk EEPROM image without needing a dump.
+ *  Image and text areas get deterministic noise so that draws have
+ *  real data to push, the structs the core parses get sane values.
+ */
+void pw_host_eeprom_synthesise(uint32_t seed) {
+    uint32_t x = seed?seed:0x12345678;
+    for(size_t i = 0; i < PW_HOST_EEPROM_SIZE; i++) {
+        x ^= x<<13;
+        x ^= x>>17;
+        x ^= x<<5;
+        pw_host_eeprom[i] = (uint8_t)x;
+    }
+
+    // reliable data, event/inventory areas and peer data start empty
+    memset(pw_host_eeprom+0x0000, 0, 0x0280);
+    memset(pw_host_eeprom+PW_EEPROM_ADDR_RECEIVED_BITFIELD, 0, 0x6c8);
+    memset(pw_host_eeprom+0xce80, 0, 0xd4c);
+    memset(pw_host_eeprom+PW_EEPROM_ADDR_MET_PEER_DATA, 0, PW_EEPROM_SIZE_MET_PEER_DATA);
+    memcpy(pw_host_eeprom+PW_EEPROM_ADDR_NINTENDO, "nintendo", PW_EEPROM_SIZE_NINTENDO);
+
+    walker_info_t info = {0};
+    info.flags = WALKER_INFO_FLAG_INIT | WALKER_INFO_FLAG_HAS_POKEMON;
+    info.protocol_ver = 2;
+    info.be_step_count = swap_bytes_u32(1234);
+    put_reliable(PW_EEPROM_ADDR_IDENTITY_DATA_1, PW_EEPROM_ADDR_IDENTITY_DATA_2, &info, sizeof(info));
+
+    health_data_t health = {0};
+    health.total_steps   = swap_bytes_u32(123456);
+    health.today_steps   = swap_bytes_u32(4321);
+    health.last_sync     = swap_bytes_u32(220924800);
+    health.total_days    = swap_bytes_u16(12);
+    health.current_watts = swap_bytes_u16(500);
+    put_reliable(PW_EEPROM_ADDR_HEALTH_DATA_1, PW_EEPROM_ADDR_HEALTH_DATA_2, &health, sizeof(health));
+
+    uint8_t marker = 0;
+    put_reliable(PW_EEPROM_ADDR_COPY_MARKER_1, PW_EEPROM_ADDR_COPY_MARKER_2, &marker, 1);
+
+    route_info_t *ri = (route_info_t*)(pw_host_eeprom+PW_EEPROM_ADDR_ROUTE_INFO);
+    memset(ri, 0, sizeof(*ri));
+    ri->pokemon_summary.le_species = 25;
+    ri->pokemon_summary.level = 10;
+    ri->pokemon_happiness = 70;
+    for(size_t i = 0; i < 3; i++) {
+        ri->route_pokemon[i].le_species = 16+i;
+        ri->route_pokemon[i].level = 5+i;
+        ri->le_route_pokemon_steps[i] = 0;
+        ri->route_pokemon_percent[i] = 33;
+    }
+    for(size_t i = 0; i < 10; i++) {
+        ri->le_route_items[i] = 1+i;
+        ri->le_route_item_steps[i] = 0;
+        ri->route_item_percent[i] = 10;
+    }
+}
@@ -0,0 +1,97 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "host.h"
+#include "ir/ir.h"
+#include "ir/ir_ring.h"
+
+/// @file host/host_ir.c
+
+/*
+ *  Scriptable IR pipe.
+ *  Frames pushed with `pw_host_ir_push_rx()` come out of `pw_ir_read()`
+ *  one per call, in order. An empty pipe behaves like a read timeout.
+ *  They are also pushed into the core's rx ring, for PW_IR_RING builds.
+ */
+
+#define HOST_IR_QUEUE_LEN   32
+
+typedef struct {
+    uint8_t data[MAX_PACKET_SIZE];
+    size_t len;
+} host_ir_frame_t;
+
+static host_ir_frame_t rx_queue[HOST_IR_QUEUE_LEN];
+static size_t rx_head = 0, rx_count = 0;
+
+static pw_host_ir_responder_t responder = 0;
+static void *responder_ctx = 0;
+
+void pw_ir_init() {
+    pw_host_ir_clear();
+}
+
+int pw_ir_read(uint8_t *buf, size_t len) {
+    pw_host_stats.ir_reads++;
+
+    if(rx_count == 0) {
+        pw_host_clock_advance_us(PW_IR_READ_TIMEOUT_US);
+        return 0;
+    }
+
+    host_ir_frame_t *f = &rx_queue[rx_head];
+    size_t n = (f->len < len)?f->len:len;
+    memcpy(buf, f->data, n);
+
+    rx_head = (rx_head+1)%HOST_IR_QUEUE_LEN;
+    rx_count--;
+
+    pw_host_stats.ir_bytes_read += n;
+    pw_host_clock_advance_us(n*PW_HOST_IR_BYTE_US);
+    return (int)n;
+}
+
+int pw_ir_write(uint8_t *buf, size_t len) {
+    pw_host_stats.ir_writes++;
+    pw_host_stats.ir_bytes_written += len;
+    pw_host_clock_advance_us(len*PW_HOST_IR_BYTE_US);
+
+    if(responder) responder(buf, len, responder_ctx);
+
+    return (int)len;
+}
+
+void pw_ir_delay_ms(size_t ms) {
+    pw_host_clock_advance_us(1000*(uint64_t)ms);
+}
+
+void pw_host_ir_push_rx(const uint8_t *data, size_t len) {
+    if(len > MAX_PACKET_SIZE) len = MAX_PACKET_SIZE;
+
+    // ring builds never call pw_ir_read(), so the queue filling up
+    // mustn't stop frames reaching the ring
+    pw_ir_ring_push_buf(data, len);
+
+    if(rx_count >= HOST_IR_QUEUE_LEN) return;
+
+    host_ir_frame_t *f = &rx_queue[(rx_head+rx_count)%HOST_IR_QUEUE_LEN];
+    memcpy(f->data, data, len);
+    f->len = len;
+    rx_count++;
+}
+
+void pw_host_ir_clear() {
+    rx_head = 0;
+    rx_count = 0;
+    pw_ir_ring_clear();
+}
+
+size_t pw_host_ir_pending() {
+    return rx_count;
+}
+
+void pw_host_ir_set_responder(pw_host_ir_responder_t f, void *ctx) {
+    responder = f;
+    responder_ctx = ctx;
+}
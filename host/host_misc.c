@@ -0,0 +1,116 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "host.h"
+#include "timer.h"
+#include "audio.h"
+#include "accel.h"
+#include "buttons.h"
+#include "flash.h"
+
+/// @file host/host_misc.c
+
+pw_host_stats_t pw_host_stats;
+
+static uint64_t host_clock_us = 0;
+static uint32_t host_steps_per_sample = 0;
+
+uint8_t sad_pokewalker[576];
+
+void pw_host_stats_reset() {
+    pw_host_stats = (pw_host_stats_t) {
+        0
+    };
+}
+
+/*
+ *  ==================================================================================
+ *  Clock
+ *  ==================================================================================
+ */
+uint64_t pw_now_us() {
+    return host_clock_us;
+}
+
+void pw_timer_delay_ms(uint64_t ms) {
+    host_clock_us += 1000*ms;
+}
+
+void pw_host_clock_advance_us(uint64_t us) {
+    host_clock_us += us;
+}
+
+uint64_t pw_host_wall_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ *  ==================================================================================
+ *  Audio, accelerometer, buttons
+ *  ==================================================================================
+ */
+void pw_audio_init() {
+}
+
+void pw_audio_play_sound_data(const pw_sound_frame_t* sound_data, size_t sz) {
+    (void)sound_data;
+    (void)sz;
+    pw_host_stats.audio_sounds++;
+}
+
+bool pw_audio_is_playing_sound() {
+    return false;
+}
+
+int8_t pw_accel_init() {
+    return 0;
+}
+
+uint32_t pw_accel_get_new_steps() {
+    return host_steps_per_sample;
+}
+
+void pw_host_accel_set_steps(uint32_t steps_per_sample) {
+    host_steps_per_sample = steps_per_sample;
+}
+
+void pw_button_init() {
+}
+
+void pw_host_press(uint8_t b) {
+    pw_button_callback(b);
+}
+
+/*
+ *  ==================================================================================
+ *  Flash
+ *  ==================================================================================
+ */
+void pw_flash_read(pw_flash_img_t img_index, uint8_t *buf) {
+    size_t sz;
+
+    switch(img_index) {
+    case FLASH_IMG_POKEWALKER:
+        sz = 256;
+        break;
+    case FLASH_IMG_FACE_NEUTRAL:
+    case FLASH_IMG_FACE_HAPPY:
+    case FLASH_IMG_FACE_SAD:
+        sz = 32;
+        break;
+    case FLASH_IMG_UP_ARROW:
+    case FLASH_IMG_IR_ACTIVE:
+        sz = 16;
+        break;
+    default:
+        sz = 0;
+        break;
+    }
+
+    memset(buf, 0x55, sz);
+}
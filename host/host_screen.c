@@ -0,0 +1,106 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "screen.h"
+
+/// @file host/host_screen.c
+
+uint8_t pw_host_screen[SCREEN_WIDTH*SCREEN_HEIGHT];
+
+static void screen_account(size_t w, size_t h) {
+    pw_host_stats.screen_draw_calls++;
+    pw_host_stats.screen_pixels += w*h;
+    pw_host_clock_advance_us(PW_HOST_SCREEN_CALL_US + (w*h*PW_HOST_SCREEN_PIXEL_NS)/1000);
+}
+
+static void screen_put(size_t x, size_t y, screen_colour_t c) {
+    if(x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT) return;
+    pw_host_screen[y*SCREEN_WIDTH + x] = c&0x03;
+}
+
+void pw_screen_init() {
+    memset(pw_host_screen, SCREEN_WHITE, sizeof(pw_host_screen));
+}
+
+/*
+ *  Pokewalker image format: 8-pixel tall strips, top to bottom.
+ *  Each strip has two bytes per column, left to right, one per bitplane.
+ *  Bit n of each byte is row n of the strip.
+ */
+void pw_screen_draw_img(pw_img_t *img, screen_pos_t x, screen_pos_t y) {
+    for(size_t py = 0; py < img->height; py++) {
+        size_t strip = py/8;
+        size_t bit = py%8;
+        for(size_t px = 0; px < img->width; px++) {
+            size_t idx = 2*(strip*img->width + px);
+            if(idx+1 >= img->size) break;
+            uint8_t lo = (img->data[idx+0]>>bit)&1;
+            uint8_t hi = (img->data[idx+1]>>bit)&1;
+            screen_put(x+px, y+py, lo | (hi<<1));
+        }
+    }
+    screen_account(img->width, img->height);
+}
+
+/*
+ *  Region of the core framebuffer, same layout as image data with
+ *  SCREEN_WIDTH columns per strip.
+ */
+void pw_screen_blit_region(const uint8_t *fb, screen_pos_t x, screen_pos_t y, screen_pos_t w, screen_pos_t h) {
+    for(size_t py = y; py < (size_t)y+h && py < SCREEN_HEIGHT; py++) {
+        size_t strip = py/8;
+        size_t bit = py%8;
+        for(size_t px = x; px < (size_t)x+w && px < SCREEN_WIDTH; px++) {
+            size_t idx = 2*(strip*SCREEN_WIDTH + px);
+            uint8_t lo = (fb[idx+0]>>bit)&1;
+            uint8_t hi = (fb[idx+1]>>bit)&1;
+            screen_put(px, py, lo | (hi<<1));
+        }
+    }
+    screen_account(w, h);
+}
+
+void pw_screen_fill_area(screen_pos_t x, screen_pos_t y, screen_pos_t w, screen_pos_t h, screen_colour_t colour) {
+    for(size_t py = 0; py < h; py++)
+        for(size_t px = 0; px < w; px++)
+            screen_put(x+px, y+py, colour);
+    screen_account(w, h);
+}
+
+void pw_screen_clear_area(screen_pos_t x, screen_pos_t y, screen_pos_t w, screen_pos_t h) {
+    pw_screen_fill_area(x, y, w, h, SCREEN_WHITE);
+}
+
+void pw_screen_draw_horiz_line(screen_pos_t x, screen_pos_t y, screen_pos_t len, screen_colour_t colour) {
+    pw_screen_fill_area(x, y, len, 1, colour);
+}
+
+void pw_screen_draw_text_box(screen_pos_t x1, screen_pos_t y1, screen_pos_t w, screen_pos_t h, screen_colour_t colour) {
+    for(size_t px = 0; px < w; px++) {
+        screen_put(x1+px, y1, colour);
+        screen_put(x1+px, y1+h-1, colour);
+    }
+    for(size_t py = 0; py < h; py++) {
+        screen_put(x1, y1+py, colour);
+        screen_put(x1+w-1, y1+py, colour);
+    }
+    screen_account(2*w, 2*h);
+}
+
+void pw_screen_clear() {
+    pw_screen_fill_area(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_WHITE);
+}
+
+int pw_host_screen_save_pgm(const char *path) {
+    static const uint8_t grey[4] = {255, 170, 85, 0};
+    FILE *f = fopen(path, "wb");
+    if(!f) return -1;
+    fprintf(f, "P5\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    for(size_t i = 0; i < sizeof(pw_host_screen); i++)
+        fputc(grey[pw_host_screen[i]&0x03], f);
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "picowalker.h"
+#include "buttons.h"
+#include "instrument.h"
+#include "eeprom_cache.h"
+
+/// @file host/main.c
+
+/*
+ *  Run the core against the in-memory drivers for a fixed number of
+ *  walker_loop() iterations and report what it cost.
+ *
+ *  usage: picowalker-core-host [options]
+ *      -n <frames>         walker_loop() iterations (default 1000)
+ *      -t <us>             virtual time added per iteration (default 10000)
+ *      -e <file>           load a 64KiB eeprom image instead of a synthetic one
+ *      -o <file>           save the eeprom image on exit
+ *      -s <file>           save the final screen as a pgm
+ *      -w <steps>          steps reported per accelerometer sample
+ *      -p <frame>:<L|M|R>  press a button at the given iteration, can repeat
+ */
+
+#define MAX_PRESSES 64
+
+typedef struct {
+    uint32_t frame;
+    uint8_t button;
+} press_t;
+
+static uint8_t parse_button(char c) {
+    switch(c) {
+    case 'L':
+    case 'l':
+        return BUTTON_L;
+    case 'M':
+    case 'm':
+        return BUTTON_M;
+    case 'R':
+    case 'r':
+        return BUTTON_R;
+    default:
+        return 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t n_frames = 1000;
+    uint64_t frame_us = 10000;
+    const char *eeprom_in = 0, *eeprom_out = 0, *screen_out = 0;
+    press_t presses[MAX_PRESSES];
+    size_t n_presses = 0;
+
+    for(int i = 1; i < argc; i++) {
+        if(i+1 >= argc || argv[i][0] != '-') {
+            fprintf(stderr, "bad argument: %s\n", argv[i]);
+            return 1;
+        }
+        const char *v = argv[++i];
+        switch(argv[i-1][1]) {
+        case 'n':
+            n_frames = strtoul(v, 0, 0);
+            break;
+        case 't':
+            frame_us = strtoull(v, 0, 0);
+            break;
+        case 'e':
+            eeprom_in = v;
+            break;
+        case 'o':
+            eeprom_out = v;
+            break;
+        case 's':
+            screen_out = v;
+            break;
+        case 'w':
+            pw_host_accel_set_steps(strtoul(v, 0, 0));
+            break;
+        case 'p': {
+            char *end;
+            uint32_t frame = strtoul(v, &end, 0);
+            uint8_t b = (*end == ':')?parse_button(end[1]):0;
+            if(b == 0 || n_presses >= MAX_PRESSES) {
+                fprintf(stderr, "bad press: %s\n", v);
+                return 1;
+            }
+            presses[n_presses++] = (press_t) {
+                .frame=frame, .button=b
+            };
+            break;
+        }
+        default:
+            fprintf(stderr, "unknown option: %s\n", argv[i-1]);
+            return 1;
+        }
+    }
+
+    if(eeprom_in) {
+        if(pw_host_eeprom_load(eeprom_in) != 0) {
+            fprintf(stderr, "could not load eeprom image %s\n", eeprom_in);
+            return 1;
+        }
+    } else {
+        pw_host_eeprom_synthesise(0);
+    }
+
+    pw_host_stats_reset();
+    walker_setup();
+
+    pw_host_stats_reset();
+    pw_instr_reset();
+    pw_eeprom_cache_reset_stats();
+    uint64_t wall_start = pw_host_wall_ns();
+    for(uint32_t f = 0; f < n_frames; f++) {
+        for(size_t i = 0; i < n_presses; i++) {
+            if(presses[i].frame == f) pw_host_press(presses[i].button);
+        }
+        walker_loop();
+        pw_host_clock_advance_us(frame_us);
+    }
+    uint64_t wall_ns = pw_host_wall_ns() - wall_start;
+
+    printf("frames:         %u\n", n_frames);
+    printf("wall time:      %.3f ms (%.2f us/frame)\n", wall_ns/1e6, wall_ns/1e3/(n_frames?n_frames:1));
+    printf("eeprom reads:   %u (%llu bytes)\n", pw_host_stats.eeprom_reads,
+           (unsigned long long)pw_host_stats.eeprom_bytes_read);
+    printf("eeprom writes:  %u (%llu bytes)\n", pw_host_stats.eeprom_writes,
+           (unsigned long long)pw_host_stats.eeprom_bytes_written);
+    printf("eeprom fills:   %u (%llu bytes)\n", pw_host_stats.eeprom_sets,
+           (unsigned long long)pw_host_stats.eeprom_bytes_set);
+    printf("draw calls:     %u (%llu pixels)\n", pw_host_stats.screen_draw_calls,
+           (unsigned long long)pw_host_stats.screen_pixels);
+    printf("ir reads:       %u (%llu bytes)\n", pw_host_stats.ir_reads,
+           (unsigned long long)pw_host_stats.ir_bytes_read);
+    printf("ir writes:      %u (%llu bytes)\n", pw_host_stats.ir_writes,
+           (unsigned long long)pw_host_stats.ir_bytes_written);
+
+    pw_eeprom_cache_print_stats();
+    pw_instr_dump();
+
+    if(screen_out) pw_host_screen_save_pgm(screen_out);
+    if(eeprom_out) pw_host_eeprom_save(eeprom_out);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "ir/ir.h"
+#include "ir/ir_ring.h"
+
+/// @file host/test_ir_ring.c
+
+/*
+ *  `pw_ir_poll_packet()` on a core built with PW_IR_RING: frames pushed
+ *  with `pw_host_ir_push_rx()` have to come out of the ring whole, one
+ *  per quiet gap, with their checksum checked. More frames than the
+ *  host's `pw_ir_read()` queue holds are sent, as nothing reads that
+ *  queue in a ring build.
+ *
+ *  usage: picowalker-test-ir-ring
+ */
+
+#define N_FRAMES    100
+#define STEP_US     100
+
+static uint8_t wire[MAX_PACKET_SIZE];
+static size_t wire_len = 0;
+
+// what the core writes out, as it would appear on the line
+static void capture(const uint8_t *data, size_t len, void *ctx) {
+    (void)ctx;
+    memcpy(wire, data, len);
+    wire_len = len;
+}
+
+/*
+ *  Poll until something other than IR_ERR_AWAITING, moving the clock on
+ *  between polls like walker_loop() would.
+ */
+static ir_err_t poll(pw_packet_t *packet, size_t len, size_t *n, uint32_t *waited_us) {
+    ir_err_t err;
+
+    *waited_us = 0;
+    while((err = pw_ir_poll_packet(packet, len, n)) == IR_ERR_AWAITING) {
+        pw_host_clock_advance_us(STEP_US);
+        *waited_us += STEP_US;
+    }
+
+    return err;
+}
+
+int main() {
+    int fails = 0;
+    pw_packet_t packet;
+    size_t n;
+    uint32_t waited;
+
+    pw_ir_init();
+    pw_ir_set_comm_state(COMM_STATE_DISCONNECTED);
+    pw_host_ir_set_responder(capture, 0);
+
+    for(size_t i = 0; i < N_FRAMES; i++) {
+        size_t len = 8 + (i*13)%129;
+
+        memset(&packet, 0, sizeof(packet));
+        packet.cmd = (uint8_t)i;
+        packet.extra = 0x01;
+        for(size_t j = 0; j < len-8; j++) packet.payload[j] = (uint8_t)(i+j);
+        pw_ir_send_packet(&packet, len, &n);
+        pw_host_ir_push_rx(wire, wire_len);
+
+        memset(&packet, 0, sizeof(packet));
+        ir_err_t err = poll(&packet, MAX_PACKET_SIZE, &n, &waited);
+
+        bool payload_ok = true;
+        for(size_t j = 0; j < len-8; j++)
+            if(packet.payload[j] != (uint8_t)(i+j)) payload_ok = false;
+
+        if(err != IR_OK || n != len || packet.cmd != (uint8_t)i || !payload_ok) {
+            printf("frame %zu: %s, %zu/%zu bytes, cmd %02x\n", i, PW_IR_ERR_NAMES[err], n, len, packet.cmd);
+            fails++;
+        } else if(waited < PW_IR_FRAME_GAP_US && len < MAX_PACKET_SIZE) {
+            printf("frame %zu: returned before the line went quiet\n", i);
+            fails++;
+        }
+    }
+
+    // a corrupted byte fails the checksum
+    memset(&packet, 0, sizeof(packet));
+    packet.cmd = CMD_PING;
+    pw_ir_send_packet(&packet, 8, &n);
+    wire[1] ^= 0x10;
+    pw_host_ir_push_rx(wire, wire_len);
+    if(poll(&packet, 8, &n, &waited) != IR_ERR_BAD_CHECKSUM) {
+        printf("corrupted frame not caught\n");
+        fails++;
+    }
+
+    // and a quiet line times out
+    if(poll(&packet, 8, &n, &waited) != IR_ERR_TIMEOUT || waited < PW_IR_READ_TIMEOUT_US) {
+        printf("no timeout on a quiet line\n");
+        fails++;
+    }
+
+    if(pw_ir_ring_dropped()) {
+        printf("%u bytes dropped by the ring\n", pw_ir_ring_dropped());
+        fails++;
+    }
+
+    printf("%s\n", fails?"FAIL":"ok");
+    return fails?1:0;
+}
@@ -0,0 +1,122 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "picowalker.h"
+#include "eeprom.h"
+#include "eeprom_map.h"
+#include "eeprom_cache.h"
+#include "eeprom_bank.h"
+#include "eeprom_erase.h"
+#include "walk_copy.h"
+#include "ir/actions.h"
+
+/// @file host/test_walk_start.c
+
+/*
+ *  Walk start against the in-memory eeprom: the staged route has to
+ *  become the route, the met peers have to read as wiped, and the other
+ *  peer play regions inside the route bank have to read as before. Run
+ *  twice, so the flip is checked in both directions.
+ *
+ *  usage: picowalker-test-walk-start
+ */
+
+typedef struct {
+    const char *name;
+    eeprom_addr_t addr;
+    uint16_t size;
+} region_t;
+
+static const region_t kept[] = {
+    {"CURRENT_PEER_TEAM_DATA", PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA, PW_EEPROM_SIZE_CURRENT_PEER_TEAM_DATA},
+    {"IMG_CURRENT_PEER_POKEMON", PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL, PW_EEPROM_SIZE_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL},
+    {"TEXT_CURRENT_PEER_POKEMON_NAME", PW_EEPROM_ADDR_TEXT_CURRENT_PEER_POKEMON_NAME, PW_EEPROM_SIZE_TEXT_CURRENT_PEER_POKEMON_NAME},
+    {"CURRENT_PEER_DATA", PW_EEPROM_ADDR_CURRENT_PEER_DATA, PW_EEPROM_SIZE_CURRENT_PEER_DATA},
+};
+#define N_KEPT  (sizeof(kept)/sizeof(kept[0]))
+
+#define STAGED_SIZE     (PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA-PW_EEPROM_ADDR_SCENARIO_STAGING_AREA)
+
+static uint8_t before[PW_EEPROM_SIZE_MET_PEER_DATA];
+static uint8_t after[PW_EEPROM_SIZE_MET_PEER_DATA];
+static uint8_t staged[STAGED_SIZE];
+
+static void fill(eeprom_addr_t addr, size_t len, uint8_t seed) {
+    for(size_t i = 0; i < len; i += sizeof(before)) {
+        size_t n = (len-i < sizeof(before))?(len-i):sizeof(before);
+        for(size_t j = 0; j < n; j++) before[j] = seed + (uint8_t)((i+j)*7);
+        pw_eeprom_cache_write(addr+i, before, n);
+    }
+}
+
+static int walk_start(int run) {
+    int fails = 0;
+    uint8_t bank = pw_eeprom_bank;
+
+    // a route being staged, and a peer play that left its data behind
+    fill(PW_EEPROM_ADDR_SCENARIO_STAGING_AREA, PW_EEPROM_SIZE_SCENARIO_STAGING_AREA, 0x10*run + 1);
+    fill(PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA, 0xf6f8-PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA, 0x10*run + 3);
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_SCENARIO_STAGING_AREA, staged, sizeof(staged));
+
+    uint8_t kept_before[N_KEPT][PW_EEPROM_SIZE_CURRENT_PEER_TEAM_DATA];
+    for(size_t i = 0; i < N_KEPT; i++)
+        pw_eeprom_cache_read(kept[i].addr, kept_before[i], kept[i].size);
+
+    pw_ir_start_walk();
+    for(size_t i = 0; i < 10000 && (pw_walk_copy_busy() || pw_eeprom_erase_pending()); i++) {
+        pw_host_clock_advance_us(10000);
+        walker_loop();
+    }
+
+    if(pw_walk_copy_busy() || pw_eeprom_erase_pending()) {
+        printf("run %d: walk start didn't finish\n", run);
+        return 1;
+    }
+
+    if(pw_eeprom_bank == bank) {
+        printf("run %d: bank still %u\n", run, bank);
+        fails++;
+    }
+
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_ROUTE_INFO, after, sizeof(staged));
+    if(memcmp(after, staged, sizeof(staged)) != 0) {
+        printf("run %d: route differs from what was staged\n", run);
+        fails++;
+    }
+
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_MET_PEER_DATA, after, PW_EEPROM_SIZE_MET_PEER_DATA);
+    size_t nonzero = 0;
+    for(size_t i = 0; i < PW_EEPROM_SIZE_MET_PEER_DATA; i++)
+        if(after[i]) nonzero++;
+    if(nonzero) {
+        printf("run %d: MET_PEER_DATA has %zu/%u nonzero bytes\n", run, nonzero, PW_EEPROM_SIZE_MET_PEER_DATA);
+        fails++;
+    }
+
+    for(size_t i = 0; i < N_KEPT; i++) {
+        pw_eeprom_cache_read(kept[i].addr, after, kept[i].size);
+        if(memcmp(after, kept_before[i], kept[i].size) != 0) {
+            printf("run %d: %s changed\n", run, kept[i].name);
+            fails++;
+        }
+    }
+
+    return fails;
+}
+
+int main() {
+    int fails = 0;
+
+    pw_host_eeprom_synthesise(0);
+    walker_setup();
+
+    for(int run = 0; run < 2; run++)
+        fails += walk_start(run);
+
+    printf("%s\n", fails?"FAIL":"ok");
+    return fails?1:0;
+}
@@ -4,6 +4,7 @@
 #include "accel.h"
 #include "globals.h"
 #include "utils.h"
+#include "health_journal.h"
 
 void pw_accel_process_steps() {
     uint32_t new_steps = pw_accel_get_new_steps();
@@ -17,5 +18,7 @@ void pw_accel_process_steps() {
     health_data_cache.current_watts += new_watts;
     if(health_data_cache.current_watts > CURRENT_WATTS_MAX) health_data_cache.current_watts = CURRENT_WATTS_MAX;
 
+    if(new_steps > 0) pw_health_mark_dirty();
+
 }
 
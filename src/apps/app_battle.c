@@ -6,6 +6,7 @@
 #include "../screen.h"
 #include "../audio.h"
 #include "../eeprom_map.h"
+#include "../eeprom_cache.h"
 #include "../globals.h"
 #include "../buttons.h"
 #include "../rand.h"
@@ -391,7 +392,7 @@ void pw_battle_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf
         if(s->battle.chosen_pokemon >= 3) {
             // event mon
             pokemon_summary_t *caught_poke = (pokemon_summary_t*)eeprom_buf;
-            pw_eeprom_read(
+            pw_eeprom_cache_read(
                 PW_EEPROM_ADDR_EVENT_POKEMON_BASIC_DATA,
                 (uint8_t*)(caught_poke),
                 sizeof(*caught_poke)
@@ -399,48 +400,49 @@ void pw_battle_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf
             if(caught_poke->le_species == 0x0000 || caught_poke->le_species == 0xffff) {
 
                 // basic data
-                pw_eeprom_read(
+                pw_eeprom_cache_read(
                     PW_EEPROM_ADDR_SPECIAL_POKEMON_BASIC_DATA,
                     (uint8_t*)(caught_poke),
                     sizeof(*caught_poke)
                 );
-                pw_eeprom_write(
+                pw_eeprom_cache_write(
                     PW_EEPROM_ADDR_EVENT_POKEMON_BASIC_DATA,
                     (uint8_t*)(caught_poke),
                     sizeof(*caught_poke)
                 );
+                pw_inventory_set(PI_EXTRA_POKEMON, caught_poke->le_species);
 
                 // extra data
-                pw_eeprom_read(
+                pw_eeprom_cache_read(
                     PW_EEPROM_ADDR_SPECIAL_POKEMON_EXTRA_DATA,
                     eeprom_buf,
                     PW_EEPROM_SIZE_SPECIAL_POKEMON_EXTRA_DATA
                 );
-                pw_eeprom_write(
+                pw_eeprom_cache_write(
                     PW_EEPROM_ADDR_EVENT_POKEMON_EXTRA_DATA,
                     eeprom_buf,
                     PW_EEPROM_SIZE_EVENT_POKEMON_EXTRA_DATA
                 );
 
                 // small sprite
-                pw_eeprom_read(
+                pw_eeprom_cache_read(
                     PW_EEPROM_ADDR_IMG_SPECIAL_POKEMON_SMALL_ANIMATED,
                     eeprom_buf,
                     PW_EEPROM_SIZE_IMG_SPECIAL_POKEMON_SMALL_ANIMATED
                 );
-                pw_eeprom_write(
+                pw_eeprom_cache_write(
                     PW_EEPROM_ADDR_IMG_EVENT_POKEMON_SMALL_ANIMATED,
                     eeprom_buf,
                     PW_EEPROM_SIZE_IMG_EVENT_POKEMON_SMALL_ANIMATED
                 );
 
                 // name text
-                pw_eeprom_read(
+                pw_eeprom_cache_read(
                     PW_EEPROM_ADDR_TEXT_SPECIAL_POKEMON_NAME,
                     eeprom_buf,
                     PW_EEPROM_SIZE_TEXT_SPECIAL_POKEMON_NAME
                 );
-                pw_eeprom_write(
+                pw_eeprom_cache_write(
                     PW_EEPROM_ADDR_TEXT_EVENT_POKEMON_NAME,
                     eeprom_buf,
                     PW_EEPROM_SIZE_TEXT_EVENT_POKEMON_NAME
@@ -456,7 +458,7 @@ void pw_battle_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf
         } else {
             // normal mon
             pokemon_summary_t caught_pokes[3];
-            pw_eeprom_read(
+            pw_eeprom_cache_read(
                 PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY,
                 (uint8_t*)caught_pokes,
                 sizeof(caught_pokes)
@@ -473,17 +475,18 @@ void pw_battle_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf
                 pw_battle_switch_substate(s, BATTLE_SWITCH);
             } else {
                 route_info_t ri;
-                pw_eeprom_read(
+                pw_eeprom_cache_read(
                     PW_EEPROM_ADDR_ROUTE_INFO,
                     (uint8_t*)(&ri),
                     sizeof(ri)
                 );
                 caught_pokes[i] = ri.route_pokemon[s->battle.chosen_pokemon];
-                pw_eeprom_write(
+                pw_eeprom_cache_write(
                     PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY,
                     (uint8_t*)caught_pokes,
                     sizeof(caught_pokes)
                 );
+                pw_inventory_set(PI_CAUGHT_POKEMON_1+i, caught_pokes[i].le_species);
                 p->sid = STATE_SPLASH;
             }
         }
@@ -542,7 +545,7 @@ void pw_battle_init_display(pw_state_t *s, const screen_flags_t *sf) {
         pw_screen_draw_text_box(0, SCREEN_HEIGHT-32, SCREEN_WIDTH, 32, SCREEN_BLACK);
 
         pw_img_t health_bar = {.width=8, .height=8, .data=eeprom_buf, .size=16};
-        pw_eeprom_read(PW_EEPROM_ADDR_IMG_RADAR_HP_BLIP, eeprom_buf, PW_EEPROM_SIZE_IMG_RADAR_HP_BLIP);
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_IMG_RADAR_HP_BLIP, eeprom_buf, PW_EEPROM_SIZE_IMG_RADAR_HP_BLIP);
 
         int8_t health = (s->battle.current_hp&THEIR_HP_MASK) >> THEIR_HP_OFFSET;
         for(int8_t i = 0; i < health; i++) {
@@ -1064,17 +1067,18 @@ void pw_battle_handle_input(pw_state_t *s, const screen_flags_t *sf, uint8_t b)
         case BUTTON_M: {
             pokemon_summary_t poke;
             route_info_t ri;
-            pw_eeprom_read(
+            pw_eeprom_cache_read(
                 PW_EEPROM_ADDR_ROUTE_INFO,
                 (uint8_t*)(&ri),
                 sizeof(ri)
             );
             poke = ri.route_pokemon[s->battle.chosen_pokemon];
-            pw_eeprom_write(
+            pw_eeprom_cache_write(
                 PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY,
                 (uint8_t*)(&poke),
                 sizeof(poke)
             );
+            pw_inventory_set(PI_CAUGHT_POKEMON_1, poke.le_species);
             s->battle.current_substate = BATTLE_GO_TO_SPLASH;
             break;
         }
@@ -6,9 +6,11 @@
 #include "../buttons.h"
 #include "../screen.h"
 #include "../eeprom_map.h"
+#include "../eeprom_async.h"
 #include "../ir/ir.h"
 #include "../ir/actions.h"
 #include "../globals.h"
+#include "../health_journal.h"
 #include "app_comms.h"
 
 /** @file app_comms.c
@@ -30,6 +32,10 @@ void pw_comms_init(pw_state_t *s, const screen_flags_t *sf) {
     s->comms.screen_state = CSS_GO_TO_SPLASH;
     s->comms.advertising_attempts = 0;  // advertising attempts
     pw_ir_set_comm_state(COMM_STATE_AWAITING);
+
+    // the game reads health data straight from the eeprom, get it there
+    // before anything is on the IR reply path
+    pw_health_commit();
 }
 
 void pw_comms_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf) {
@@ -44,7 +50,7 @@ void pw_comms_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf)
         break;
     }
     case COMM_STATE_SLAVE: {
-        err = pw_ir_recv_packet(&packet_buf, PACKET_BUF_SIZE, &n_rw);
+        err = pw_ir_poll_packet(&packet_buf, PACKET_BUF_SIZE, &n_rw);
         if(err == IR_OK || err == IR_ERR_SIZE_MISMATCH) {
             err = pw_action_slave_perform_request(&packet_buf, n_rw);
         }
@@ -61,6 +67,9 @@ void pw_comms_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf)
     }
     } // switch(cs)
 
+    // nothing has arrived yet, check again next loop
+    if(err == IR_ERR_AWAITING) return;
+
     if(err != IR_OK) {
         printf("\tError code: %02x: %s\n\tState: %d\n\tSubstate %d\n",
                err, PW_IR_ERR_NAMES[err],
@@ -74,7 +83,9 @@ void pw_comms_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf)
 
     switch(s->comms.screen_state) {
     case CSS_GO_TO_SPLASH: {
-        p->sid = STATE_SPLASH;
+        // walk start copies the route in the background
+        if(!pw_eeprom_async_busy())
+            p->sid = STATE_SPLASH;
         break;
     }
     default: {
@@ -4,6 +4,7 @@
 #include "../buttons.h"
 #include "../eeprom_map.h"
 #include "../eeprom.h"
+#include "../eeprom_cache.h"
 #include "../screen.h"
 #include "../audio.h"
 #include "../states.h"
@@ -84,7 +85,7 @@ static uint16_t get_item(app_dowsing_t *dowsing, route_info_t *ri, health_data_t
         uint16_t le_steps;
         uint8_t  percent;
     } event_item;
-    pw_eeprom_read(PW_EEPROM_ADDR_SPECIAL_ITEM, (uint8_t*)(&event_item), sizeof(event_item));
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_SPECIAL_ITEM, (uint8_t*)(&event_item), sizeof(event_item));
 
     uint8_t rnd = pw_rand()%100;
 
@@ -137,7 +138,7 @@ static void replace_item_draw_init(pw_state_t *s, const screen_flags_t *sf) {
 
 void pw_dowsing_init(pw_state_t *s, const screen_flags_t *sf) {
     route_info_t ri;
-    pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_INFO, (uint8_t*)(&ri), sizeof(ri));
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_ROUTE_INFO, (uint8_t*)(&ri), sizeof(ri));
 
     s->dowsing.chosen_item = get_item(&(s->dowsing), &ri, &health_data_cache);
     printf("chosen item index: 0x%04x\n", s->dowsing.chosen_item);
@@ -157,7 +158,7 @@ void pw_dowsing_init(pw_state_t *s, const screen_flags_t *sf) {
 
 void pw_dowsing_init_display(pw_state_t *s, const screen_flags_t *sf) {
     pw_img_t grass = {.data=img_buf, .width=16, .height=16, .size=PW_EEPROM_SIZE_IMG_DOWSING_BUSH_DARK};
-    pw_eeprom_read(
+    pw_eeprom_cache_read(
         PW_EEPROM_ADDR_IMG_DOWSING_BUSH_DARK,
         grass.data,
         PW_EEPROM_SIZE_IMG_DOWSING_BUSH_DARK
@@ -277,7 +278,7 @@ static void replace_item_draw_update(pw_state_t *s, const screen_flags_t *sf) {
         uint16_t pad;
     } inv[3];
 
-    pw_eeprom_read(
+    pw_eeprom_cache_read(
         PW_EEPROM_ADDR_OBTAINED_ITEMS,
         (uint8_t*)inv,
         PW_EEPROM_SIZE_OBTAINED_ITEMS
@@ -370,7 +371,7 @@ void pw_dowsing_handle_input(pw_state_t *s, const screen_flags_t *sf, uint8_t b)
                 uint16_t pad;
             } inv[3];
 
-            pw_eeprom_read(
+            pw_eeprom_cache_read(
                 PW_EEPROM_ADDR_OBTAINED_ITEMS,
                 (uint8_t*)inv,
                 PW_EEPROM_SIZE_OBTAINED_ITEMS
@@ -378,11 +379,12 @@ void pw_dowsing_handle_input(pw_state_t *s, const screen_flags_t *sf, uint8_t b)
 
             printf("replacing index %d with 0x%04x\n", s->dowsing.current_cursor, s->dowsing.chosen_item);
             inv[s->dowsing.current_cursor].le_item = s->dowsing.chosen_item;
-            pw_eeprom_write(
+            pw_eeprom_cache_write(
                 PW_EEPROM_ADDR_OBTAINED_ITEMS,
                 (uint8_t*)inv,
                 PW_EEPROM_SIZE_OBTAINED_ITEMS
             );
+            pw_inventory_set(PI_DOWSED_ITEM_1+s->dowsing.current_cursor, s->dowsing.chosen_item);
 
             switch_substate(s, DOWSING_QUITTING);
             PW_SET_REQUEST(s->requests, PW_REQUEST_REDRAW);
@@ -487,7 +489,7 @@ void pw_dowsing_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *s
             uint16_t pad;
         } inv[3];
 
-        pw_eeprom_read(
+        pw_eeprom_cache_read(
             PW_EEPROM_ADDR_OBTAINED_ITEMS,
             (uint8_t*)inv,
             PW_EEPROM_SIZE_OBTAINED_ITEMS
@@ -522,11 +524,12 @@ void pw_dowsing_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *s
         } else {
 
             inv[avail].le_item = s->dowsing.chosen_item;
-            pw_eeprom_write(
+            pw_eeprom_cache_write(
                 PW_EEPROM_ADDR_OBTAINED_ITEMS,
                 (uint8_t*)inv,
                 PW_EEPROM_SIZE_OBTAINED_ITEMS
             );
+            pw_inventory_set(PI_DOWSED_ITEM_1+avail, s->dowsing.chosen_item);
 
             s->dowsing.user_input = false;
             s->dowsing.current_substate = DOWSING_AWAIT_INPUT;
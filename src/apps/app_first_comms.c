@@ -5,11 +5,13 @@
 #include "../flash.h"
 #include "../states.h"
 #include "../eeprom.h"
+#include "../eeprom_async.h"
 #include "../ir/ir.h"
 #include "../ir/actions.h"
 #include "../screen.h"
 #include "../buttons.h"
 #include "../globals.h"
+#include "../health_journal.h"
 #include "app_first_comms.h"
 
 
@@ -30,6 +32,9 @@ void pw_first_comms_init(pw_state_t *s, const screen_flags_t *sf) {
     s->comms.advertising_attempts = 0;
     s->comms.timer = 0;
     pw_ir_set_comm_state(COMM_STATE_DISCONNECTED);
+
+    // as in pw_comms_init()
+    pw_health_commit();
 }
 
 void pw_first_comms_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_t *sf) {
@@ -44,7 +49,7 @@ void pw_first_comms_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_
     }
     case COMM_STATE_SLAVE: {
         printf("Slave waiting\n");
-        err = pw_ir_recv_packet(&packet_buf, PACKET_BUF_SIZE, &n_rw);
+        err = pw_ir_poll_packet(&packet_buf, PACKET_BUF_SIZE, &n_rw);
         if(err == IR_OK || err == IR_ERR_SIZE_MISMATCH) {
             err = pw_action_slave_perform_request(&packet_buf, n_rw);
         }
@@ -64,7 +69,7 @@ void pw_first_comms_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_
         if(s->comms.screen_state == FC_SUBSTATE_TIMEOUT && s->comms.timer == 0) {
             s->comms.screen_state = FC_SUBSTATE_WAITING;
         }
-        if(s->comms.screen_state == FC_SUBSTATE_SUCCESS) {
+        if(s->comms.screen_state == FC_SUBSTATE_SUCCESS && !pw_eeprom_async_busy()) {
             p->sid = STATE_SPLASH;
         }
         break;
@@ -76,6 +81,9 @@ void pw_first_comms_event_loop(pw_state_t *s, pw_state_t *p, const screen_flags_
     }
     } // switch(cs)
 
+    // nothing has arrived yet, check again next loop
+    if(err == IR_ERR_AWAITING) return;
+
     if(err != IR_OK) {
         printf("\tError code: %02x: %s\n\tState: %d\n\tSubstate %d\n",
                err, PW_IR_ERR_NAMES[err],
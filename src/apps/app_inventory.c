@@ -3,6 +3,7 @@
 #include "app_inventory.h"
 
 #include "../eeprom.h"
+#include "../eeprom_cache.h"
 #include "../eeprom_map.h"
 #include "../screen.h"
 #include "../buttons.h"
@@ -207,7 +208,7 @@ static void draw_animated_sprite(pw_state_t *s, const screen_flags_t *sf) {
         pokemon_index_t pokemon_index = pw_pokemon_id_to_pokemon_index(gdetailed.entries[s->inventory.current_cursor]);
         pw_pokemon_index_to_small_sprite(pokemon_index, buf, (sf->frame&ANIM_FRAME_NORMAL_TIME)>>ANIM_FRAME_NORMAL_TIME_OFFSET);
     } else {
-        pw_eeprom_read(
+        pw_eeprom_cache_read(
             PW_EEPROM_ADDR_IMG_TREASURE_LARGE,
             buf,
             PW_EEPROM_SIZE_IMG_TREASURE_LARGE
@@ -283,10 +284,10 @@ static void pw_inventory_draw_screen1(pw_state_t *s, const screen_flags_t *sf) {
     uint8_t buf_item[PW_EEPROM_SIZE_IMG_ITEM];
 
     pw_img_t pokeball = {.height=8, .width=8, .data=buf_pokeball, .size=PW_EEPROM_SIZE_IMG_BALL};
-    pw_eeprom_read(PW_EEPROM_ADDR_IMG_BALL, buf_pokeball, PW_EEPROM_SIZE_IMG_BALL);
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_IMG_BALL, buf_pokeball, PW_EEPROM_SIZE_IMG_BALL);
 
     pw_img_t item = {.height=8, .width=8, .data=buf_item, .size=PW_EEPROM_SIZE_IMG_ITEM};
-    pw_eeprom_read(PW_EEPROM_ADDR_IMG_ITEM, buf_item, PW_EEPROM_SIZE_IMG_ITEM);
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_IMG_ITEM, buf_item, PW_EEPROM_SIZE_IMG_ITEM);
 
     uint8_t xs[] = {8, 24, 32, 40, 48};
     const uint8_t yp = 24, yi = 40;
@@ -355,7 +356,7 @@ static void pw_inventory_draw_screen2(pw_state_t *s, const screen_flags_t *sf) {
 
     uint8_t buf_item[PW_EEPROM_SIZE_IMG_ITEM];
     pw_img_t item = {.height=8, .width=8, .data=buf_item, .size=PW_EEPROM_SIZE_IMG_ITEM};
-    pw_eeprom_read(PW_EEPROM_ADDR_IMG_ITEM, buf_item, PW_EEPROM_SIZE_IMG_ITEM);
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_IMG_ITEM, buf_item, PW_EEPROM_SIZE_IMG_ITEM);
 
     uint8_t x0 = 16, y0 = 24;
     for(uint8_t i = 0; i < gbrief.n_peer_play_items; i++) {
@@ -10,6 +10,7 @@
 #include "../audio.h"
 #include "../utils.h"
 #include "../eeprom.h"
+#include "../eeprom_cache.h"
 #include "../eeprom_map.h"
 #include "../rand.h"
 #include "../buttons.h"
@@ -57,7 +58,7 @@ static void draw_cursor_update(pw_state_t *s, const screen_flags_t *sf) {
  */
 void pw_poke_radar_init(pw_state_t *s, const screen_flags_t *sf) {
     route_info_t ri;
-    pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_INFO, (uint8_t*)&ri, sizeof(ri));
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_ROUTE_INFO, (uint8_t*)&ri, sizeof(ri));
 
     pw_poke_radar_choose_pokemon(&(s->radar), &ri, &health_data_cache);
 
@@ -82,7 +83,7 @@ void pw_poke_radar_init_display(pw_state_t *s, const screen_flags_t *sf) {
     switch(s->radar.current_substate) {
     case RADAR_CHOOSING: {
         pw_img_t bush = {.width=32, .height=24, .data=eeprom_buf, .size=192};
-        pw_eeprom_read(PW_EEPROM_ADDR_IMG_RADAR_BUSH, eeprom_buf, PW_EEPROM_SIZE_IMG_RADAR_BUSH);
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_IMG_RADAR_BUSH, eeprom_buf, PW_EEPROM_SIZE_IMG_RADAR_BUSH);
 
         for(uint8_t i = 0; i < 4; i++)
             pw_screen_draw_img(&bush, bush_xs[i], bush_ys[i]);
@@ -284,18 +285,18 @@ void pw_poke_radar_choose_pokemon(app_radar_t *radar, route_info_t *ri, health_d
     uint32_t today_steps =hd->today_steps;
 
     special_inventory_t inv;
-    pw_eeprom_read(PW_EEPROM_ADDR_RECEIVED_BITFIELD, (uint8_t*)&inv, 1);
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_RECEIVED_BITFIELD, (uint8_t*)&inv, 1);
 
     int8_t event_index;
-    pw_eeprom_read(PW_EEPROM_ADDR_SPECIAL_POKEMON_EVENT_INDEX, (uint8_t*)(&event_index), 1);
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_SPECIAL_POKEMON_EVENT_INDEX, (uint8_t*)(&event_index), 1);
 
-    //pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_POKEMON, (uint8_t*)(ri->route_pokemon), PW_EEPROM_SIZE_ROUTE_POKEMON);
+    //pw_eeprom_cache_read(PW_EEPROM_ADDR_ROUTE_POKEMON, (uint8_t*)(ri->route_pokemon), PW_EEPROM_SIZE_ROUTE_POKEMON);
 
     bool valid_event = event_index > 0;
     if( valid_event && !inv.event_pokemon ) {
         // event
         pokemon_summary_t event_pokemon;
-        pw_eeprom_read(
+        pw_eeprom_cache_read(
             PW_EEPROM_ADDR_SPECIAL_POKEMON_BASIC_DATA,
             (uint8_t*)&event_pokemon,
             sizeof(event_pokemon)
@@ -305,7 +306,7 @@ void pw_poke_radar_choose_pokemon(app_radar_t *radar, route_info_t *ri, health_d
             uint16_t le_steps;
             uint8_t chance;
         } special;
-        pw_eeprom_read(PW_EEPROM_ADDR_SPECIAL_POKEMON_STEPS_REQUIRED, (uint8_t*)&special, sizeof(special));
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_SPECIAL_POKEMON_STEPS_REQUIRED, (uint8_t*)&special, sizeof(special));
 
         if(today_steps > special.le_steps) {
             if( pw_rand()%100 < special.chance ) {
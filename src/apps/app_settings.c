@@ -9,6 +9,8 @@
 #include "../buttons.h"
 #include "../globals.h"
 #include "../eeprom.h"
+#include "../eeprom_cache.h"
+#include "../health_journal.h"
 
 #define N_MAIN_OPTIONS 2
 #define N_SOUND_OPTIONS 3
@@ -123,7 +125,7 @@ void pw_settings_init_display(pw_state_t *s, const screen_flags_t *sf) {
             .width=8, .height=16,
             .data=eeprom_buf, .size=PW_EEPROM_ADDR_IMG_CONTRAST_DEMONSTRATOR
         };
-        pw_eeprom_read(
+        pw_eeprom_cache_read(
             PW_EEPROM_ADDR_IMG_CONTRAST_DEMONSTRATOR,
             eeprom_buf,
             PW_EEPROM_SIZE_IMG_CONTRAST_DEMONSTRATOR
@@ -269,6 +271,7 @@ void pw_settings_handle_input(pw_state_t *s, const screen_flags_t *sf, uint8_t b
         }
         case BUTTON_M: {
             s->settings.current_substate = SETTINGS_GO_TO_SPLASH;
+            pw_health_commit();
 	    pw_audio_play_sound(SOUND_NAVIGATE_MENU);
             break;
         }
@@ -293,6 +296,7 @@ void pw_settings_handle_input(pw_state_t *s, const screen_flags_t *sf, uint8_t b
         }
         case BUTTON_M: {
             s->settings.current_substate = SETTINGS_GO_TO_SPLASH;
+            pw_health_commit();
 	    pw_audio_play_sound(SOUND_NAVIGATE_MENU);
             break;
         }
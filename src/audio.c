@@ -2,6 +2,7 @@
 #include "audio.h"
 
 #include "eeprom.h"
+#include "eeprom_cache.h"
 #include "eeprom_map.h"
 #include "utils.h"
 
@@ -20,11 +21,11 @@ pw_sound_frame_t sound_data_buffer[MAX_SOUND_DATA];
 void pw_audio_play_sound(uint8_t sound_id) {
     sound_info_t sound_info;
     if (pw_audio_volume != VOLUME_NONE) {
-        pw_eeprom_read(PW_EEPROM_ADDR_SOUND_OFFSET + sound_id * sizeof(sound_info_t), (uint8_t*)&sound_info, sizeof(sound_info_t));
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_SOUND_OFFSET + sound_id * sizeof(sound_info_t), (uint8_t*)&sound_info, sizeof(sound_info_t));
 	sound_info.offset = sound_info.offset;
 
 	if (sound_info.length <= MAX_SOUND_DATA) {
-            pw_eeprom_read(PW_EEPROM_ADDR_SOUND_DATA + sound_info.offset, (uint8_t*)sound_data_buffer, sound_info.length);
+            pw_eeprom_cache_read(PW_EEPROM_ADDR_SOUND_DATA + sound_info.offset, (uint8_t*)sound_data_buffer, sound_info.length);
 
 	    // TODO: Some sum being calculated here?
 	    
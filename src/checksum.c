@@ -0,0 +1,152 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#include "checksum.h"
+
+#ifdef PW_CHECKSUM_SSE2
+#include <emmintrin.h>
+#endif
+
+/// @file checksum.c
+
+void pw_checksum_sum_ref(const uint8_t *data, size_t len, pw_sum_t *s) {
+    uint32_t even = 0, odd = 0;
+
+    for(size_t i = 0; i < len; i++) {
+        if(i&1) {
+            odd += data[i];
+        } else {
+            even += data[i];
+        }
+    }
+
+    s->even = even;
+    s->odd = odd;
+}
+
+/*
+ *  A word is split into two 0x00ff00ff lanes, the bytes at word offsets
+ *  0 and 2, and those at 1 and 3. Each 16-bit half of a lane holds at
+ *  most 255*256 after 256 words, so carries are folded out once per block
+ *  of that many.
+ */
+#define WORDS_PER_FOLD  256
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define LANE_EVEN(w)    (((w)>>8) & 0x00ff00ffu)
+#define LANE_ODD(w)     ((w) & 0x00ff00ffu)
+#else
+#define LANE_EVEN(w)    ((w) & 0x00ff00ffu)
+#define LANE_ODD(w)     (((w)>>8) & 0x00ff00ffu)
+#endif
+
+#define LANE_FOLD(l)    (((l) & 0xffffu) + ((l)>>16))
+
+// the words are read out of byte buffers
+#ifdef __GNUC__
+typedef uint32_t __attribute__((may_alias)) word_t;
+#else
+typedef uint32_t word_t;
+#endif
+
+void pw_checksum_sum_words(const uint8_t *data, size_t len, pw_sum_t *s) {
+    uint32_t even = 0, odd = 0;
+    size_t head = (4 - ((uintptr_t)data & 3)) & 3;
+
+    if(head > len) head = len;
+
+    // bytes up to the first aligned word, counted from data[0]
+    for(size_t i = 0; i < head; i++) {
+        if(i&1) {
+            odd += data[i];
+        } else {
+            even += data[i];
+        }
+    }
+
+    const word_t *w = (const word_t*)(data + head);
+    size_t n_words = (len - head)/4;
+    uint32_t we = 0, wo = 0;    // relative to the aligned words
+
+    while(n_words > 0) {
+        size_t n = (n_words < WORDS_PER_FOLD)?n_words:WORDS_PER_FOLD;
+        uint32_t le = 0, lo = 0;
+
+        n_words -= n;
+        for(; n >= 4; n -= 4, w += 4) {
+            uint32_t w0 = w[0], w1 = w[1], w2 = w[2], w3 = w[3];
+            le += LANE_EVEN(w0) + LANE_EVEN(w1) + LANE_EVEN(w2) + LANE_EVEN(w3);
+            lo += LANE_ODD(w0) + LANE_ODD(w1) + LANE_ODD(w2) + LANE_ODD(w3);
+        }
+        for(; n > 0; n--, w++) {
+            le += LANE_EVEN(*w);
+            lo += LANE_ODD(*w);
+        }
+
+        we += LANE_FOLD(le);
+        wo += LANE_FOLD(lo);
+    }
+
+    // an odd head shifts the words by one byte
+    if(head&1) {
+        even += wo;
+        odd += we;
+    } else {
+        even += we;
+        odd += wo;
+    }
+
+    // tail, again counted from data[0]
+    for(size_t i = (const uint8_t*)w - data; i < len; i++) {
+        if(i&1) {
+            odd += data[i];
+        } else {
+            even += data[i];
+        }
+    }
+
+    s->even = even;
+    s->odd = odd;
+}
+
+#ifdef PW_CHECKSUM_SSE2
+/*
+ *  Mask the even (low) bytes of each 16-bit lane, shift the odd ones
+ *  down, and let psadbw add 8 of each into 64-bit lanes. Nothing to fold.
+ */
+void pw_checksum_sum_sse2(const uint8_t *data, size_t len, pw_sum_t *s) {
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i ae = zero, ao = zero;
+    size_t i = 0;
+
+    for(; i+16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&data[i]);
+        ae = _mm_add_epi64(ae, _mm_sad_epu8(_mm_and_si128(v, mask), zero));
+        ao = _mm_add_epi64(ao, _mm_sad_epu8(_mm_srli_epi16(v, 8), zero));
+    }
+
+    uint32_t even = (uint32_t)_mm_cvtsi128_si32(ae) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(ae, 8));
+    uint32_t odd = (uint32_t)_mm_cvtsi128_si32(ao) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(ao, 8));
+
+    // i is a multiple of 16, so still even here
+    for(; i < len; i++) {
+        if(i&1) {
+            odd += data[i];
+        } else {
+            even += data[i];
+        }
+    }
+
+    s->even = even;
+    s->odd = odd;
+}
+#endif
+
+void pw_checksum_sum(const uint8_t *data, size_t len, pw_sum_t *s) {
+#ifdef PW_CHECKSUM_SSE2
+    pw_checksum_sum_sse2(data, len, s);
+#else
+    pw_checksum_sum_words(data, len, s);
+#endif
+}
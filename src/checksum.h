@@ -0,0 +1,42 @@
+#ifndef PW_CHECKSUM_H
+#define PW_CHECKSUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// @file checksum.h
+
+/*
+ *  Byte sums behind `pw_ir_checksum_seeded()` and `pw_eeprom_checksum()`.
+ *
+ *  Both checksums only need the sum of the bytes at even offsets and the
+ *  sum of the bytes at odd offsets (mod 2^32): the IR one is
+ *  seed + (even<<8) + odd folded to 16 bits, the eeprom one is
+ *  1 + even + odd truncated to 8 bits. So the kernels just produce those
+ *  two sums, several bytes per step with the carries folded once per
+ *  block, and all variants give exactly the same numbers.
+ *
+ *  - `_ref`   one byte per iteration
+ *  - `_words` aligned 32-bit loads, unrolled, for Cortex-M0+ and other
+ *             cores without unaligned loads
+ *  - `_sse2`  16 bytes per step, for the host build and tools
+ *
+ *  `pw_checksum_sum()` is the best one for the target.
+ */
+
+typedef struct {
+    uint32_t even;  // bytes at offsets 0, 2, 4...
+    uint32_t odd;   // bytes at offsets 1, 3, 5...
+} pw_sum_t;
+
+void pw_checksum_sum_ref(const uint8_t *data, size_t len, pw_sum_t *s);
+void pw_checksum_sum_words(const uint8_t *data, size_t len, pw_sum_t *s);
+
+#if defined(__SSE2__)
+#define PW_CHECKSUM_SSE2
+void pw_checksum_sum_sse2(const uint8_t *data, size_t len, pw_sum_t *s);
+#endif
+
+void pw_checksum_sum(const uint8_t *data, size_t len, pw_sum_t *s);
+
+#endif /* PW_CHECKSUM_H */
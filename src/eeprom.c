@@ -1,88 +1,246 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "eeprom.h"
+#include "eeprom_cache.h"
+#include "eeprom_erase.h"
+#include "health_journal.h"
 #include "eeprom_map.h"
+#include "checksum.h"
 #include "globals.h"
 #include "utils.h"
 
 static const char const NINTENDO_STRING[] = "nintendo";
 
-int pw_eeprom_reliable_read(eeprom_addr_t addr1, eeprom_addr_t addr2, uint8_t *buf, size_t len) {
+/*
+ *  Write `len` bytes without crossing an eeprom page, so each piece is
+ *  one write cycle on the chip.
+ */
+static void pw_eeprom_write_paged(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    while(len > 0) {
+        size_t n = PW_EEPROM_PAGE_SIZE - (addr%PW_EEPROM_PAGE_SIZE);
+        if(n > len) n = len;
+
+        pw_eeprom_cache_write(addr, buf, n);
+        addr += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+/*
+ *  Write one copy of a reliable record (data + checksum) unless the
+ *  eeprom already holds exactly that. Returns whether it was written.
+ */
+static bool pw_eeprom_write_copy(eeprom_addr_t addr, uint8_t *rec, size_t len) {
+    uint8_t cur[PW_EEPROM_RELIABLE_MAX_LEN+1];
+
+    pw_eeprom_cache_read(addr, cur, len);
+    if(memcmp(cur, rec, len) == 0) return false;
+
+    pw_eeprom_write_paged(addr, rec, len);
+    return true;
+}
+
+/*
+ *  Reliable records whose two copies are known to agree, as of the last
+ *  full check or reliable write. Reads of these only look at copy 1.
+ *  Anything else gets copy 1 on the fast path too, but is queued to have
+ *  both copies checked (and repaired) from walker_loop() when idle. A
+ *  bad copy 1 is read from copy 2 and queued the same way.
+ */
+#define RELIABLE_KNOWN_MAX  8
+#define RELIABLE_QUEUE_LEN  4
+
+typedef struct {
+    eeprom_addr_t addr1, addr2;
+    uint8_t len;
+} reliable_record_t;
+
+static reliable_record_t reliable_known[RELIABLE_KNOWN_MAX];
+static size_t n_reliable_known = 0;
+
+static reliable_record_t reliable_queue[RELIABLE_QUEUE_LEN];
+static size_t n_reliable_queue = 0;
+
+static int pw_eeprom_reliable_find(reliable_record_t *recs, size_t n, eeprom_addr_t addr1) {
+    for(size_t i = 0; i < n; i++)
+        if(recs[i].addr1 == addr1) return (int)i;
+    return -1;
+}
+
+static void pw_eeprom_reliable_mark_known(eeprom_addr_t addr1, eeprom_addr_t addr2, size_t len) {
+    int i = pw_eeprom_reliable_find(reliable_known, n_reliable_known, addr1);
+    if(i >= 0) {
+        reliable_known[i].len = len;
+        return;
+    }
 
-    uint8_t chk1, chk2;
-    uint8_t written_chk1, written_chk2;
+    // forget the oldest if full, it just gets checked again
+    if(n_reliable_known == RELIABLE_KNOWN_MAX) {
+        memmove(&reliable_known[0], &reliable_known[1], (RELIABLE_KNOWN_MAX-1)*sizeof(reliable_record_t));
+        n_reliable_known--;
+    }
+    reliable_known[n_reliable_known++] = (reliable_record_t) {
+        addr1, addr2, len
+    };
+}
 
-    bool area1_ok, area2_ok, area_mismatch;;
+static void pw_eeprom_reliable_queue_check(eeprom_addr_t addr1, eeprom_addr_t addr2, size_t len) {
+    if(pw_eeprom_reliable_find(reliable_queue, n_reliable_queue, addr1) >= 0) return;
+    if(n_reliable_queue == RELIABLE_QUEUE_LEN) return;  // will be queued again on the next read
 
-    pw_eeprom_read(addr2, buf, len);
-    pw_eeprom_read(addr2+len, &written_chk2, 1);
-    chk2 = pw_eeprom_checksum(buf, len);
-    area2_ok = chk2 == written_chk2;
+    reliable_queue[n_reliable_queue++] = (reliable_record_t) {
+        addr1, addr2, len
+    };
+}
 
-    pw_eeprom_read(addr1, buf, len);
-    pw_eeprom_read(addr1+len, &written_chk1, 1);
-    chk1 = pw_eeprom_checksum(buf, len);
-    area1_ok = chk1 == written_chk1;
+/*
+ *  Something other than a reliable write touched [addr, addr+len),
+ *  check any record there again before trusting copy 1 alone.
+ */
+void pw_eeprom_reliable_invalidate(eeprom_addr_t addr, size_t len) {
+    uint32_t end = (uint32_t)addr + len;
+
+    for(size_t i = 0; i < n_reliable_known;) {
+        reliable_record_t *r = &reliable_known[i];
+        bool hit = (addr < r->addr1+r->len+1 && end > r->addr1) ||
+                   (addr < r->addr2+r->len+1 && end > r->addr2);
+        if(hit) {
+            *r = reliable_known[--n_reliable_known];
+        } else {
+            i++;
+        }
+    }
+}
 
-    area_mismatch = chk2 != chk1;
+/*
+ *  Read and compare both copies, rewriting a bad or stale one from the
+ *  good one. Both bad means the record is lost (or was never written),
+ *  it reads as 0xff and nothing is written.
+ */
+static int pw_eeprom_reliable_check(eeprom_addr_t addr1, eeprom_addr_t addr2, uint8_t *buf, size_t len) {
+
+    uint8_t rec1[PW_EEPROM_RELIABLE_MAX_LEN+1];
+    uint8_t rec2[PW_EEPROM_RELIABLE_MAX_LEN+1];
+    bool area1_ok, area2_ok;
+    int r = 0;
+
+    pw_eeprom_cache_read(addr1, rec1, len+1);
+    pw_eeprom_cache_read(addr2, rec2, len+1);
+    area1_ok = pw_eeprom_checksum(rec1, len) == rec1[len];
+    area2_ok = pw_eeprom_checksum(rec2, len) == rec2[len];
 
     if(area1_ok) {
-        // use area 1
-
-        if(area_mismatch || !area2_ok) {
-            // if 1 and 2 are different, or if area 2 is bad
-            // assume 1 is newer, overwrite area 2 with area 1
-            // TODO: Add this back
-            //pw_eeprom_write(addr2, buf, len);
-            //pw_eeprom_write(addr2+len, &chk1, 1);
-            return 2;   // positive so ok, but telling that area 2 was bad
+        // copy 1 is newest, bring copy 2 in line
+        if(memcmp(rec1, rec2, len+1) != 0) {
+            pw_eeprom_write_paged(addr2, rec1, len+1);
+            r = 2;  // positive so ok, but telling that area 2 was bad
         }
+        memcpy(buf, rec1, len);
     } else if(area2_ok) {
-        // if area 1 is bad and area 2 is ok
-        // use area 2 and overwrite area 1
-        pw_eeprom_read(addr2, buf, len);
-        // TODO: Add this back
-        //pw_eeprom_write(addr1, buf, len);
-        //pw_eeprom_write(addr1+len, &chk2, 1);
-        return 1;   // positive so ok, but telling that area 1 was bad
-
+        pw_eeprom_write_paged(addr1, rec2, len+1);
+        memcpy(buf, rec2, len);
+        r = 1;      // positive so ok, but telling that area 1 was bad
     } else {
-        // if both are bad, we're buggered. fill both areas with 0xff
-        for(size_t i = 0; i < len; i++)
-            buf[i] = 0xff;
-        chk1 = 0xff;
-        chk2 = 0xff;
-        // TODO: Add this back
-        //pw_eeprom_write(addr1, buf, len);
-        //pw_eeprom_write(addr1+len, &chk1, 1);
-        //pw_eeprom_write(addr2, buf, len);
-        //pw_eeprom_write(addr2+len, &chk2, 1);
+        // if both are bad, we're buggered. leave them for whoever
+        // writes the record next
+        memset(buf, 0xff, len);
         return -1;
     }
 
+    pw_eeprom_reliable_mark_known(addr1, addr2, len);
+    return r;
+}
+
+int pw_eeprom_reliable_read(eeprom_addr_t addr1, eeprom_addr_t addr2, uint8_t *buf, size_t len) {
+
+    if(len > PW_EEPROM_RELIABLE_MAX_LEN) {
+        uint8_t chk;
+        pw_eeprom_cache_read(addr1, buf, len);
+        pw_eeprom_cache_read(addr1+len, &chk, 1);
+        if(pw_eeprom_checksum(buf, len) == chk) return 0;
+
+        pw_eeprom_cache_read(addr2, buf, len);
+        pw_eeprom_cache_read(addr2+len, &chk, 1);
+        return (pw_eeprom_checksum(buf, len) == chk)?1:-1;
+    }
+
+    // fast path: copy 1 and its checksum in one read
+    uint8_t rec[PW_EEPROM_RELIABLE_MAX_LEN+1];
+    pw_eeprom_cache_read(addr1, rec, len+1);
+
+    if(pw_eeprom_checksum(rec, len) == rec[len]) {
+        memcpy(buf, rec, len);
+        if(pw_eeprom_reliable_find(reliable_known, n_reliable_known, addr1) < 0)
+            pw_eeprom_reliable_queue_check(addr1, addr2, len);
+        return 0;
+    }
+
+    // copy 1 is bad: use copy 2, and have the idle check rewrite copy 1
+    pw_eeprom_cache_read(addr2, rec, len+1);
+    if(pw_eeprom_checksum(rec, len) == rec[len]) {
+        memcpy(buf, rec, len);
+        pw_eeprom_reliable_queue_check(addr1, addr2, len);
+        return 1;   // positive so ok, but telling that area 1 was bad
+    }
+
+    memset(buf, 0xff, len);
+    return -1;
+}
+
+/*
+ *  Check one queued record. Called from walker_loop() once the
+ *  state has had its turn.
+ */
+void pw_eeprom_reliable_idle() {
+    uint8_t buf[PW_EEPROM_RELIABLE_MAX_LEN];
 
-    return 0;
+    if(n_reliable_queue == 0) return;
+
+    reliable_record_t r = reliable_queue[0];
+    n_reliable_queue--;
+    memmove(&reliable_queue[0], &reliable_queue[1], n_reliable_queue*sizeof(reliable_record_t));
+
+    pw_eeprom_reliable_check(r.addr1, r.addr2, buf, r.len);
 }
 
+/*
+ *  Each copy goes out as one buffer with its checksum byte on the end,
+ *  instead of a separate write for the data and the checksum.
+ *  Returns how many copies actually changed.
+ */
 int pw_eeprom_reliable_write(eeprom_addr_t addr1, eeprom_addr_t addr2, uint8_t *buf, size_t len) {
 
     uint8_t chk = pw_eeprom_checksum(buf, len);
-    pw_eeprom_write(addr1, buf, len);
-    pw_eeprom_write(addr1+len, &chk, 1);
-    pw_eeprom_write(addr2, buf, len);
-    pw_eeprom_write(addr2+len, &chk, 1);
 
-    return 0;
+    if(len > PW_EEPROM_RELIABLE_MAX_LEN) {
+        pw_eeprom_cache_write(addr1, buf, len);
+        pw_eeprom_cache_write(addr1+len, &chk, 1);
+        pw_eeprom_cache_write(addr2, buf, len);
+        pw_eeprom_cache_write(addr2+len, &chk, 1);
+        return 2;
+    }
+
+    uint8_t rec[PW_EEPROM_RELIABLE_MAX_LEN+1];
+    memcpy(rec, buf, len);
+    rec[len] = chk;
+
+    int n = 0;
+    n += pw_eeprom_write_copy(addr1, rec, len+1);
+    n += pw_eeprom_write_copy(addr2, rec, len+1);
+    pw_eeprom_reliable_mark_known(addr1, addr2, len);
+
+    return n;
 }
 
 uint8_t pw_eeprom_checksum(uint8_t *buf, size_t len) {
-    uint8_t chk = 1;
-    for(size_t i = 0; i < len; i++)
-        chk += buf[i];
+    pw_sum_t s;
+    pw_checksum_sum(buf, len, &s);
 
-    return chk;
+    return (uint8_t)(1 + s.even + s.odd);
 }
 
 void pw_eeprom_reset(bool clear_events, bool clear_steps) {
@@ -144,27 +302,29 @@ void pw_eeprom_reset(bool clear_events, bool clear_steps) {
     pw_eeprom_initialise_health_data(clear_steps);
 
     if(clear_steps) {
-        pw_eeprom_set_area(0xce80, 0, 0xd4c);
+        pw_eeprom_erase_lazy(0xce80, 0xd4c);
     } else {
-        pw_eeprom_set_area(PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY, 0, 0x64);
-        pw_eeprom_set_area(PW_EEPROM_ADDR_EVENT_LOG, 0, PW_EEPROM_SIZE_EVENT_LOG);
-        pw_eeprom_set_area(PW_EEPROM_ADDR_HISTORIC_STEP_COUNT, 0, PW_EEPROM_SIZE_HISTORIC_STEP_COUNT);
+        pw_eeprom_erase_lazy(PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY, 0x64);
+        pw_eeprom_erase_lazy(PW_EEPROM_ADDR_EVENT_LOG, PW_EEPROM_SIZE_EVENT_LOG);
+        pw_eeprom_erase_lazy(PW_EEPROM_ADDR_HISTORIC_STEP_COUNT, PW_EEPROM_SIZE_HISTORIC_STEP_COUNT);
     }
 
     if(clear_events) {
-        pw_eeprom_set_area(PW_EEPROM_ADDR_RECEIVED_BITFIELD, 0, 0x6c8);
+        pw_eeprom_erase_lazy(PW_EEPROM_ADDR_RECEIVED_BITFIELD, 0x6c8);
     }
 
-    pw_eeprom_set_area(PW_EEPROM_ADDR_MET_PEER_DATA, 0, PW_EEPROM_SIZE_MET_PEER_DATA);
+    pw_eeprom_erase_lazy(PW_EEPROM_ADDR_MET_PEER_DATA, PW_EEPROM_SIZE_MET_PEER_DATA);
+    pw_inventory_invalidate_all();
 
-    pw_eeprom_write(PW_EEPROM_ADDR_NINTENDO, NINTENDO_STRING, PW_EEPROM_SIZE_NINTENDO);
+    pw_eeprom_cache_write(PW_EEPROM_ADDR_NINTENDO, NINTENDO_STRING, PW_EEPROM_SIZE_NINTENDO);
+    pw_eeprom_cache_flush();
 }
 
 void pw_eeprom_initialise_health_data(bool clear_time) {
     if(clear_time) {
         health_data_cache.total_steps = 0;
         health_data_cache.total_days = 0;
-        health_data_cache.last_sync = swap_bytes_u32(220924800); // 2nd Jan 2008
+        health_data_cache.last_sync = 220924800; // 2nd Jan 2008
         health_data_cache.today_steps = 0;
     }
 
@@ -175,18 +335,13 @@ void pw_eeprom_initialise_health_data(bool clear_time) {
     health_data_cache.settings |= 0x24;
     health_data_cache.event_log_index = 0;
 
-    pw_eeprom_reliable_write(
-        PW_EEPROM_ADDR_HEALTH_DATA_1,
-        PW_EEPROM_ADDR_HEALTH_DATA_2,
-        (uint8_t*)(&health_data_cache),
-        sizeof(health_data_t)
-    );
+    pw_health_commit();
 }
 
 
 bool pw_eeprom_check_for_nintendo() {
     uint8_t *buf = eeprom_buf;
-    pw_eeprom_read(PW_EEPROM_ADDR_NINTENDO, buf, PW_EEPROM_SIZE_NINTENDO);
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_NINTENDO, buf, PW_EEPROM_SIZE_NINTENDO);
 
     uint8_t i = 0;
     for(i = 0; i < PW_EEPROM_SIZE_NINTENDO; i++) {
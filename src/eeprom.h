@@ -21,11 +21,35 @@ extern void pw_eeprom_set_area(eeprom_addr_t addr, uint8_t v, size_t len);
 /*
  *  Derivative functions, driver agnostic
  */
+
+// largest reliable record written in one piece, identity data is 104
+#define PW_EEPROM_RELIABLE_MAX_LEN  128
+
 int pw_eeprom_reliable_read(eeprom_addr_t addr1, eeprom_addr_t addr2, uint8_t *buf, size_t len);
 int pw_eeprom_reliable_write(eeprom_addr_t addr1, eeprom_addr_t addr2, uint8_t *buf, size_t len);
+void pw_eeprom_reliable_invalidate(eeprom_addr_t addr, size_t len);
+void pw_eeprom_reliable_idle();
 uint8_t pw_eeprom_checksum(uint8_t *buf, size_t len);
 bool pw_eeprom_check_for_nintendo();
 void pw_eeprom_reset(bool clear_events, bool clear_steps);
 void pw_eeprom_initialise_health_data(bool clear_time);
 
+#ifdef PW_INSTRUMENT
+#include "instrument.h"
+
+/*
+ *  Count driver traffic per call site, see instrument.h
+ */
+int pw_instr_eeprom_read(const char *file, const char *func, int line,
+                         eeprom_addr_t addr, uint8_t *buf, size_t len);
+int pw_instr_eeprom_write(const char *file, const char *func, int line,
+                          eeprom_addr_t addr, uint8_t *buf, size_t len);
+void pw_instr_eeprom_set_area(const char *file, const char *func, int line,
+                              eeprom_addr_t addr, uint8_t v, size_t len);
+
+#define pw_eeprom_read(addr, buf, len)      pw_instr_eeprom_read(PW_INSTR_HERE, addr, buf, len)
+#define pw_eeprom_write(addr, buf, len)     pw_instr_eeprom_write(PW_INSTR_HERE, addr, buf, len)
+#define pw_eeprom_set_area(addr, v, len)    pw_instr_eeprom_set_area(PW_INSTR_HERE, addr, v, len)
+#endif /* PW_INSTRUMENT */
+
 #endif /* PW_EEPROM_H */
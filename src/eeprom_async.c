@@ -0,0 +1,289 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "eeprom_async.h"
+#include "eeprom_cache.h"
+#include "eeprom_erase.h"
+#include "eeprom_bank.h"
+#include "eeprom.h"
+#include "timer.h"
+
+/// @file eeprom_async.c
+
+static pw_eeprom_req_t *queue[PW_EEPROM_ASYNC_QUEUE_LEN];
+static size_t q_head = 0, q_count = 0;
+
+static const pw_eeprom_dma_t *dma = 0;
+static volatile bool dma_busy = false;
+static bool in_poll = false;
+
+/*
+ *  Progress through the chunk at the head request's `done`.
+ *  A copy reads into `bounce` first, then writes it out.
+ */
+enum {
+    PHASE_START,
+    PHASE_COPY_WRITE,
+    PHASE_FINISH,
+};
+
+static uint8_t phase = PHASE_START;
+static uint16_t chunk_n = 0;
+static uint8_t bounce[PW_EEPROM_PAGE_SIZE];
+
+// a dma read still needs lazily erased pages zeroed once it lands
+static uint8_t *dma_read_buf = 0;
+static eeprom_addr_t dma_read_addr = 0;
+
+bool pw_eeprom_async_submit(pw_eeprom_req_t *req) {
+    if(q_count >= PW_EEPROM_ASYNC_QUEUE_LEN) return false;
+    if(pw_eeprom_async_pending(req)) return false;
+
+    req->done = 0;
+    req->state = PW_EEPROM_REQ_QUEUED;
+    queue[(q_head+q_count)%PW_EEPROM_ASYNC_QUEUE_LEN] = req;
+    q_count++;
+
+    return true;
+}
+
+bool pw_eeprom_async_read(pw_eeprom_req_t *req, eeprom_addr_t addr, uint8_t *buf, size_t len,
+                          pw_eeprom_req_cb_t cb, void *ctx) {
+    req->op = PW_EEPROM_REQ_READ;
+    req->addr = addr;
+    req->buf = buf;
+    req->len = len;
+    req->cb = cb;
+    req->ctx = ctx;
+    return pw_eeprom_async_submit(req);
+}
+
+bool pw_eeprom_async_write(pw_eeprom_req_t *req, eeprom_addr_t addr, uint8_t *buf, size_t len,
+                           pw_eeprom_req_cb_t cb, void *ctx) {
+    req->op = PW_EEPROM_REQ_WRITE;
+    req->addr = addr;
+    req->buf = buf;
+    req->len = len;
+    req->cb = cb;
+    req->ctx = ctx;
+    return pw_eeprom_async_submit(req);
+}
+
+bool pw_eeprom_async_fill(pw_eeprom_req_t *req, eeprom_addr_t addr, uint8_t v, size_t len,
+                          pw_eeprom_req_cb_t cb, void *ctx) {
+    req->op = PW_EEPROM_REQ_FILL;
+    req->addr = addr;
+    req->v = v;
+    req->len = len;
+    req->cb = cb;
+    req->ctx = ctx;
+    return pw_eeprom_async_submit(req);
+}
+
+bool pw_eeprom_async_copy(pw_eeprom_req_t *req, eeprom_addr_t dst, eeprom_addr_t src, size_t len,
+                          pw_eeprom_req_cb_t cb, void *ctx) {
+    req->op = PW_EEPROM_REQ_COPY;
+    req->addr = dst;
+    req->src = src;
+    req->len = len;
+    req->cb = cb;
+    req->ctx = ctx;
+    return pw_eeprom_async_submit(req);
+}
+
+/*
+ *  Start a chunk read/write. Returns true if it is already done,
+ *  false if a dma transfer is in flight.
+ */
+static bool io_read(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    if(dma && dma->start_read) {
+        eeprom_addr_t phys;
+        pw_eeprom_bank_map(addr, len, &phys);   // chunks never cross a bank edge
+
+        pw_eeprom_cache_sync(addr, len, false);
+        dma_read_addr = addr;
+        dma_read_buf = buf;
+        dma_busy = true;
+        if(dma->start_read(phys, buf, len)) return false;
+        dma_busy = false;
+        dma_read_buf = 0;
+    }
+
+    pw_eeprom_cache_read(addr, buf, len);
+    return true;
+}
+
+static bool io_write(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    if(dma && dma->start_write) {
+        eeprom_addr_t phys;
+        pw_eeprom_bank_map(addr, len, &phys);
+
+        pw_eeprom_erase_claim(addr, len);
+        pw_eeprom_cache_sync(addr, len, true);
+        dma_busy = true;
+        if(dma->start_write(phys, buf, len)) return false;
+        dma_busy = false;
+    }
+
+    pw_eeprom_cache_write(addr, buf, len);
+    return true;
+}
+
+/*
+ *  Largest piece from `done` that crosses no eeprom page on either side.
+ */
+static uint16_t chunk_len(pw_eeprom_req_t *r) {
+    size_t n = PW_EEPROM_PAGE_SIZE - (r->addr+r->done)%PW_EEPROM_PAGE_SIZE;
+
+    if(r->op == PW_EEPROM_REQ_COPY) {
+        size_t m = PW_EEPROM_PAGE_SIZE - (r->src+r->done)%PW_EEPROM_PAGE_SIZE;
+        if(m < n) n = m;
+    }
+    if(n > (size_t)(r->len - r->done)) n = r->len - r->done;
+
+    return n;
+}
+
+/*
+ *  Move the head request on by one chunk.
+ *  Returns false if it has to wait for dma.
+ */
+static bool run_chunk(pw_eeprom_req_t *r) {
+    eeprom_addr_t addr = r->addr + r->done;
+
+    if(phase == PHASE_START) {
+        chunk_n = chunk_len(r);
+
+        switch(r->op) {
+        case PW_EEPROM_REQ_READ:
+            phase = PHASE_FINISH;
+            if(!io_read(addr, &r->buf[r->done], chunk_n)) return false;
+            break;
+        case PW_EEPROM_REQ_WRITE:
+            phase = PHASE_FINISH;
+            if(!io_write(addr, &r->buf[r->done], chunk_n)) return false;
+            break;
+        case PW_EEPROM_REQ_FILL:
+            phase = PHASE_FINISH;
+            pw_eeprom_cache_set_area(addr, r->v, chunk_n);
+            break;
+        case PW_EEPROM_REQ_COPY:
+            phase = PHASE_COPY_WRITE;
+            if(!io_read(r->src + r->done, bounce, chunk_n)) return false;
+            break;
+        }
+    }
+
+    if(phase == PHASE_COPY_WRITE) {
+        phase = PHASE_FINISH;
+        if(!io_write(addr, bounce, chunk_n)) return false;
+    }
+
+    r->done += chunk_n;
+    phase = PHASE_START;
+
+    if(r->done >= r->len) {
+        q_head = (q_head+1)%PW_EEPROM_ASYNC_QUEUE_LEN;
+        q_count--;
+        r->state = PW_EEPROM_REQ_DONE;
+        if(r->cb) r->cb(r, r->ctx);
+    }
+
+    return true;
+}
+
+/*
+ *  Work on the queue for about `budget_us`, at least one chunk.
+ *  Returns true while anything is left.
+ */
+bool pw_eeprom_async_poll(uint32_t budget_us) {
+    uint64_t start = pw_now_us();
+
+    if(dma_busy) return true;
+
+    if(dma_read_buf) {
+        pw_eeprom_erase_filter_read(dma_read_addr, dma_read_buf, chunk_n);
+        dma_read_buf = 0;
+    }
+
+    in_poll = true;
+    while(q_count > 0) {
+        pw_eeprom_req_t *r = queue[q_head];
+        r->state = PW_EEPROM_REQ_ACTIVE;
+
+        if(!run_chunk(r)) break;
+        if(pw_now_us() - start >= budget_us) break;
+    }
+    in_poll = false;
+
+    return q_count > 0;
+}
+
+static bool overlaps(eeprom_addr_t a, size_t len, eeprom_addr_t b, size_t blen) {
+    return a < (uint32_t)b+blen && (uint32_t)a+len > b;
+}
+
+/*
+ *  Does anything still queued write to [addr, addr+len), or, if
+ *  `writing`, read from it?
+ */
+static bool queue_conflicts(eeprom_addr_t addr, size_t len, bool writing) {
+    for(size_t i = 0; i < q_count; i++) {
+        pw_eeprom_req_t *r = queue[(q_head+i)%PW_EEPROM_ASYNC_QUEUE_LEN];
+        size_t left = r->len - r->done;
+
+        switch(r->op) {
+        case PW_EEPROM_REQ_READ:
+            if(writing && overlaps(addr, len, r->addr+r->done, left)) return true;
+            break;
+        case PW_EEPROM_REQ_COPY:
+            if(writing && overlaps(addr, len, r->src+r->done, left)) return true;
+        // fall through
+        default:
+            if(overlaps(addr, len, r->addr+r->done, left)) return true;
+            break;
+        }
+    }
+    return false;
+}
+
+/*
+ *  A synchronous access to [addr, addr+len) is about to happen. Run the
+ *  queue until nothing queued touches that range in a way that would
+ *  make the result depend on the order. Accesses made by the queue
+ *  itself (chunks and callbacks) are already in order and don't wait.
+ */
+void pw_eeprom_async_fence(eeprom_addr_t addr, size_t len, bool writing) {
+    if(q_count == 0 || in_poll) return;
+
+    while(queue_conflicts(addr, len, writing))
+        pw_eeprom_async_poll(0);
+}
+
+/*
+ *  Blocking fallback: run the queue until `req` is done.
+ */
+void pw_eeprom_async_wait(pw_eeprom_req_t *req) {
+    while(pw_eeprom_async_pending(req))
+        pw_eeprom_async_poll(UINT32_MAX);
+}
+
+bool pw_eeprom_async_busy() {
+    return q_count > 0;
+}
+
+bool pw_eeprom_async_pending(pw_eeprom_req_t *req) {
+    return req->state == PW_EEPROM_REQ_QUEUED || req->state == PW_EEPROM_REQ_ACTIVE;
+}
+
+void pw_eeprom_async_set_dma(const pw_eeprom_dma_t *hooks) {
+    dma = hooks;
+}
+
+/*
+ *  Called by the driver when a transfer it started has finished.
+ */
+void pw_eeprom_async_dma_done() {
+    dma_busy = false;
+}
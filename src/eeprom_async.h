@@ -0,0 +1,99 @@
+#ifndef PW_EEPROM_ASYNC_H
+#define PW_EEPROM_ASYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "eeprom.h"
+
+/// @file eeprom_async.h
+
+/*
+ *  Queue of eeprom requests that complete in the background.
+ *
+ *  Requests are owned by the caller and must stay alive until done.
+ *  walker_loop() calls `pw_eeprom_async_poll()`, which works through the
+ *  queue one eeprom page at a time for up to a time budget, then
+ *  returns. When a request completes its state becomes
+ *  PW_EEPROM_REQ_DONE and its callback (if any) is called from the poll.
+ *
+ *  Everything goes through the eeprom cache, so sync and async accesses
+ *  see the same data. A driver that can move data without the CPU
+ *  registers `pw_eeprom_dma_t` hooks; those get whole page chunks and
+ *  call `pw_eeprom_async_dma_done()` from their completion interrupt.
+ *  Without hooks each chunk is a normal blocking driver call.
+ *
+ *  The cache calls `pw_eeprom_async_fence()` before every synchronous
+ *  access, so a read never sees data older than a queued write to the
+ *  same range, and a write never gets overtaken by one.
+ */
+
+#ifndef PW_EEPROM_ASYNC_QUEUE_LEN
+#define PW_EEPROM_ASYNC_QUEUE_LEN   8
+#endif
+
+#ifndef PW_EEPROM_ASYNC_BUDGET_US
+#define PW_EEPROM_ASYNC_BUDGET_US   5000    // per walker_loop()
+#endif
+
+typedef enum {
+    PW_EEPROM_REQ_READ,     // eeprom -> buf
+    PW_EEPROM_REQ_WRITE,    // buf -> eeprom
+    PW_EEPROM_REQ_FILL,     // v -> eeprom
+    PW_EEPROM_REQ_COPY,     // eeprom -> eeprom
+} pw_eeprom_op_t;
+
+typedef enum {
+    PW_EEPROM_REQ_IDLE,
+    PW_EEPROM_REQ_QUEUED,
+    PW_EEPROM_REQ_ACTIVE,
+    PW_EEPROM_REQ_DONE,
+} pw_eeprom_req_state_t;
+
+typedef struct pw_eeprom_req_s pw_eeprom_req_t;
+typedef void (*pw_eeprom_req_cb_t)(pw_eeprom_req_t *req, void *ctx);
+
+struct pw_eeprom_req_s {
+    uint8_t op;             // pw_eeprom_op_t
+    volatile uint8_t state; // pw_eeprom_req_state_t
+    eeprom_addr_t addr;     // eeprom address, destination for a copy
+    eeprom_addr_t src;      // copy source
+    uint8_t *buf;
+    uint8_t v;
+    uint16_t len;
+    uint16_t done;          // bytes completed so far
+    pw_eeprom_req_cb_t cb;
+    void *ctx;
+};
+
+/*
+ *  Optional driver hooks, given physical addresses. Return true if the
+ *  transfer was started, false to have the chunk done with the blocking
+ *  driver instead.
+ */
+typedef struct {
+    bool (*start_read)(eeprom_addr_t addr, uint8_t *buf, size_t len);
+    bool (*start_write)(eeprom_addr_t addr, uint8_t *buf, size_t len);
+} pw_eeprom_dma_t;
+
+bool pw_eeprom_async_submit(pw_eeprom_req_t *req);
+bool pw_eeprom_async_read(pw_eeprom_req_t *req, eeprom_addr_t addr, uint8_t *buf, size_t len,
+                          pw_eeprom_req_cb_t cb, void *ctx);
+bool pw_eeprom_async_write(pw_eeprom_req_t *req, eeprom_addr_t addr, uint8_t *buf, size_t len,
+                           pw_eeprom_req_cb_t cb, void *ctx);
+bool pw_eeprom_async_fill(pw_eeprom_req_t *req, eeprom_addr_t addr, uint8_t v, size_t len,
+                          pw_eeprom_req_cb_t cb, void *ctx);
+bool pw_eeprom_async_copy(pw_eeprom_req_t *req, eeprom_addr_t dst, eeprom_addr_t src, size_t len,
+                          pw_eeprom_req_cb_t cb, void *ctx);
+
+bool pw_eeprom_async_poll(uint32_t budget_us);
+void pw_eeprom_async_wait(pw_eeprom_req_t *req);
+bool pw_eeprom_async_busy();
+bool pw_eeprom_async_pending(pw_eeprom_req_t *req);
+void pw_eeprom_async_fence(eeprom_addr_t addr, size_t len, bool writing);
+
+void pw_eeprom_async_set_dma(const pw_eeprom_dma_t *hooks);
+void pw_eeprom_async_dma_done();
+
+#endif /* PW_EEPROM_ASYNC_H */
@@ -0,0 +1,67 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "eeprom_bank.h"
+#include "eeprom_cache.h"
+#include "eeprom.h"
+
+/// @file eeprom_bank.c
+
+uint8_t pw_eeprom_bank = 0;
+
+void pw_eeprom_bank_init() {
+    uint8_t bank = 0;
+
+    pw_eeprom_bank = 0;
+    int r = pw_eeprom_reliable_read(
+                PW_EEPROM_ADDR_BANK_SELECT_1,
+                PW_EEPROM_ADDR_BANK_SELECT_2,
+                &bank,
+                PW_EEPROM_SIZE_BANK_SELECT
+            );
+
+    pw_eeprom_bank = (r >= 0 && bank == 1)?1:0;
+}
+
+/*
+ *  Make `bank` live. Doing it twice is harmless, so an interrupted walk
+ *  start can simply repeat it.
+ */
+void pw_eeprom_bank_select(uint8_t bank) {
+    if(bank == pw_eeprom_bank) return;
+
+    // everything must be on the eeprom before the selector changes
+    pw_eeprom_cache_flush();
+
+    pw_eeprom_bank = bank;
+    pw_eeprom_reliable_write(
+        PW_EEPROM_ADDR_BANK_SELECT_1,
+        PW_EEPROM_ADDR_BANK_SELECT_2,
+        &bank,
+        PW_EEPROM_SIZE_BANK_SELECT
+    );
+    pw_eeprom_cache_flush();
+}
+
+size_t pw_eeprom_bank_map_slow(eeprom_addr_t addr, size_t len, eeprom_addr_t *phys) {
+    uint32_t a = addr, end = (uint32_t)addr + len;
+    uint32_t lo, hi, other;
+
+    if(a >= PW_EEPROM_BANK_A && a < PW_EEPROM_BANK_A+PW_EEPROM_BANK_SIZE) {
+        lo = PW_EEPROM_BANK_A;
+        other = PW_EEPROM_BANK_B;
+    } else if(a >= PW_EEPROM_BANK_B && a < (uint32_t)PW_EEPROM_BANK_B+PW_EEPROM_BANK_SIZE) {
+        lo = PW_EEPROM_BANK_B;
+        other = PW_EEPROM_BANK_A;
+    } else {
+        // outside both, up to whichever comes next
+        *phys = addr;
+        hi = (a < PW_EEPROM_BANK_A)?PW_EEPROM_BANK_A:PW_EEPROM_BANK_B;
+        return (end > hi)?(hi-a):len;
+    }
+
+    hi = lo + PW_EEPROM_BANK_SIZE;
+    *phys = other + (a - lo);
+    return (end > hi)?(hi-a):len;
+}
@@ -0,0 +1,62 @@
+#ifndef PW_EEPROM_BANK_H
+#define PW_EEPROM_BANK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "eeprom.h"
+#include "eeprom_map.h"
+
+/// @file eeprom_bank.h
+
+/*
+ *  Double-buffered route area.
+ *
+ *  The live route (0x8f00-0xb7ff) and the scenario staging area
+ *  (0xd700-0xffff) are the same size. Instead of copying staging over
+ *  the route at walk start, the two physical areas swap roles: when
+ *  bank 1 is selected, every access to one of them through
+ *  `pw_eeprom_cache_*()` goes to the other. So the game and the rest of
+ *  the core keep seeing the canonical map, and a walk start is a single
+ *  selector write.
+ *
+ *  The selector is a reliable record at the end of the system pages,
+ *  after the erase bitmap (0x017e and 0x027e), which the game never
+ *  writes. It reads as bank 0 when it's not valid.
+ *  Everything above the driver (cache lines, the lazy erase bitmap, the
+ *  async queue) works in canonical addresses except the cache, which
+ *  sits below the translation and works in physical ones.
+ *
+ *  Bank B also holds the peer play regions (0xdc00-0xf6f7), which are not
+ *  part of the route and have to read the same after a flip. The walk
+ *  copy carries them to the other side before it flips (see
+ *  walk_copy.h), so only the route image really swaps.
+ */
+
+#define PW_EEPROM_BANK_SIZE             0x2900
+#define PW_EEPROM_BANK_A                PW_EEPROM_ADDR_ROUTE_INFO
+#define PW_EEPROM_BANK_B                PW_EEPROM_ADDR_SCENARIO_STAGING_AREA
+
+// canonical address of the same offset in the other bank, for bank B
+#define PW_EEPROM_BANK_TWIN(a)          ((a) - PW_EEPROM_BANK_B + PW_EEPROM_BANK_A)
+
+extern uint8_t pw_eeprom_bank;
+
+void pw_eeprom_bank_init();
+void pw_eeprom_bank_select(uint8_t bank);
+size_t pw_eeprom_bank_map_slow(eeprom_addr_t addr, size_t len, eeprom_addr_t *phys);
+
+/*
+ *  Physical address of canonical `addr`. Returns how many bytes from
+ *  there on are contiguous, at most `len`.
+ */
+static inline size_t pw_eeprom_bank_map(eeprom_addr_t addr, size_t len, eeprom_addr_t *phys) {
+    if(pw_eeprom_bank == 0) {
+        *phys = addr;
+        return len;
+    }
+    return pw_eeprom_bank_map_slow(addr, len, phys);
+}
+
+#endif /* PW_EEPROM_BANK_H */
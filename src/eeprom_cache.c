@@ -0,0 +1,510 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PW_EEPROM_CACHE_INTERNAL
+#include "eeprom_cache.h"
+#include "eeprom.h"
+#include "eeprom_erase.h"
+#include "eeprom_bank.h"
+#include "eeprom_async.h"
+#include "eeprom_map.h"
+
+/// @file eeprom_cache.c
+
+static pw_eeprom_cache_stats_t stats;
+
+/*
+ *  Pinned regions: small records the game polls over and over during a
+ *  connection. They are loaded on first use, never evicted, and kept up
+ *  to date by every write, so reading them never waits for the eeprom.
+ *  Copy 1 of identity + health (back to back, checksums included) and
+ *  the watts the game reads at 0xce8a.
+ */
+typedef struct {
+    eeprom_addr_t addr;
+    uint8_t len;
+    uint8_t off;    // into pinned_data
+} pinned_region_t;
+
+#define PINNED_ID_LEN       (PW_EEPROM_ADDR_HEALTH_DATA_CHK_1+1-PW_EEPROM_ADDR_IDENTITY_DATA_1)
+
+static const pinned_region_t pinned[] = {
+    {PW_EEPROM_ADDR_IDENTITY_DATA_1, PINNED_ID_LEN, 0},
+    {PW_EEPROM_ADDR_0xce8a, PW_EEPROM_SIZE_0xce8a, PINNED_ID_LEN},
+};
+#define N_PINNED    (sizeof(pinned)/sizeof(pinned[0]))
+
+static uint8_t pinned_data[PINNED_ID_LEN+PW_EEPROM_SIZE_0xce8a];
+static uint8_t pinned_valid = 0;    // bitmask over pinned[]
+
+#if PW_EEPROM_CACHE_PAGES > 0
+
+#define PAGE_OF(a)      ((a)/PW_EEPROM_PAGE_SIZE)
+#define PAGE_ADDR(p)    ((uint32_t)(p)*PW_EEPROM_PAGE_SIZE)
+
+typedef struct {
+    uint32_t last_used;
+    uint16_t page;
+    uint8_t valid;
+    uint8_t dirty;
+    uint8_t dirty_lo, dirty_hi;     // dirty byte range in the page, [lo, hi]
+    uint8_t data[PW_EEPROM_PAGE_SIZE];
+} cache_line_t;
+
+static cache_line_t lines[PW_EEPROM_CACHE_PAGES];
+static uint32_t lru_clock = 0;
+static volatile bool busy = false;
+
+static cache_line_t *cache_lookup(uint16_t page) {
+    for(size_t i = 0; i < PW_EEPROM_CACHE_PAGES; i++) {
+        if(lines[i].valid && lines[i].page == page) return &lines[i];
+    }
+    return 0;
+}
+
+static void cache_writeback(cache_line_t *l) {
+    if(!l->valid || !l->dirty) return;
+
+    pw_eeprom_write(
+        PAGE_ADDR(l->page) + l->dirty_lo,
+        &l->data[l->dirty_lo],
+        l->dirty_hi - l->dirty_lo + 1
+    );
+    l->dirty = 0;
+    stats.writebacks++;
+}
+
+static void cache_mark_dirty(cache_line_t *l, size_t lo, size_t hi) {
+    if(!l->dirty) {
+        l->dirty = 1;
+        l->dirty_lo = lo;
+        l->dirty_hi = hi;
+        return;
+    }
+    if(lo < l->dirty_lo) l->dirty_lo = lo;
+    if(hi > l->dirty_hi) l->dirty_hi = hi;
+}
+
+/*
+ *  Take the least recently used line for `page`, writing it back first
+ *  if needed. When `fill` is set, load the page from the driver.
+ */
+static cache_line_t *cache_alloc(uint16_t page, bool fill) {
+    cache_line_t *victim = &lines[0];
+    for(size_t i = 0; i < PW_EEPROM_CACHE_PAGES; i++) {
+        if(!lines[i].valid) {
+            victim = &lines[i];
+            break;
+        }
+        if(lines[i].last_used < victim->last_used) victim = &lines[i];
+    }
+
+    cache_writeback(victim);
+
+    victim->valid = 0;
+    if(fill) {
+        pw_eeprom_read(PAGE_ADDR(page), victim->data, PW_EEPROM_PAGE_SIZE);
+        stats.fills++;
+    }
+    victim->page = page;
+    victim->dirty = 0;
+    victim->valid = 1;
+    return victim;
+}
+
+/*
+ *  Copy of `[addr, addr+len)` that only touches lines already cached.
+ *  `src` is 0 for a fill with `v`, otherwise new data for those bytes.
+ *  If `dst` is set, dirty bytes are copied out to it instead.
+ */
+static void cache_patch(eeprom_addr_t addr, uint8_t *dst, uint8_t *src, uint8_t v, size_t len) {
+    uint32_t end = (uint32_t)addr + len;
+
+    for(size_t i = 0; i < PW_EEPROM_CACHE_PAGES; i++) {
+        cache_line_t *l = &lines[i];
+        if(!l->valid) continue;
+
+        uint32_t lo = PAGE_ADDR(l->page), hi = lo + PW_EEPROM_PAGE_SIZE;
+        if(hi <= addr || lo >= end) continue;
+        if(lo < addr) lo = addr;
+        if(hi > end) hi = end;
+
+        size_t off = lo - PAGE_ADDR(l->page);
+        if(dst) {
+            if(!l->dirty) continue;
+            memcpy(&dst[lo-addr], &l->data[off], hi-lo);
+        } else if(src) {
+            memcpy(&l->data[off], &src[lo-addr], hi-lo);
+        } else {
+            memset(&l->data[off], v, hi-lo);
+        }
+    }
+}
+
+static int cache_read(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    if(len == 0) return 0;
+
+    if(busy) {
+        // interrupted another cache call, don't touch the line layout
+        pw_eeprom_read(addr, buf, len);
+        cache_patch(addr, buf, 0, 0, len);
+        stats.bypass_bytes += len;
+        return 0;
+    }
+    busy = true;
+
+    bool allocate = len <= PW_EEPROM_CACHE_BYPASS_LEN;
+    uint32_t a = addr, end = (uint32_t)addr + len;
+    uint32_t run_start = a;   // start of pending uncached run
+    bool in_run = false;
+
+    while(a < end) {
+        uint16_t page = PAGE_OF(a);
+        uint32_t page_end = PAGE_ADDR(page+1);
+        uint32_t chunk_end = (page_end < end)?page_end:end;
+        size_t off = a - PAGE_ADDR(page);
+
+        cache_line_t *l = cache_lookup(page);
+        if(!l && allocate) {
+            l = cache_alloc(page, true);
+            stats.read_misses++;
+        } else if(l) {
+            stats.read_hits++;
+        }
+
+        if(l) {
+            if(in_run) {
+                pw_eeprom_read(run_start, &buf[run_start-addr], a-run_start);
+                stats.bypass_bytes += a-run_start;
+                in_run = false;
+            }
+            memcpy(&buf[a-addr], &l->data[off], chunk_end-a);
+            l->last_used = ++lru_clock;
+        } else if(!in_run) {
+            run_start = a;
+            in_run = true;
+        }
+
+        a = chunk_end;
+    }
+
+    if(in_run) {
+        pw_eeprom_read(run_start, &buf[run_start-addr], end-run_start);
+        stats.bypass_bytes += end-run_start;
+    }
+
+    busy = false;
+    return 0;
+}
+
+static int cache_write(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    if(len == 0) return 0;
+
+    if(busy || len > PW_EEPROM_CACHE_BYPASS_LEN) {
+        pw_eeprom_write(addr, buf, len);
+        cache_patch(addr, 0, buf, 0, len);
+        stats.bypass_bytes += len;
+        return 0;
+    }
+    busy = true;
+
+    uint32_t a = addr, end = (uint32_t)addr + len;
+    while(a < end) {
+        uint16_t page = PAGE_OF(a);
+        uint32_t page_end = PAGE_ADDR(page+1);
+        uint32_t chunk_end = (page_end < end)?page_end:end;
+        size_t off = a - PAGE_ADDR(page);
+
+        cache_line_t *l = cache_lookup(page);
+        if(l) {
+            stats.write_hits++;
+        } else {
+            // whole page overwritten, no need to read it first
+            bool whole = (off == 0) && (chunk_end == page_end);
+            l = cache_alloc(page, !whole);
+            stats.write_misses++;
+        }
+
+        memcpy(&l->data[off], &buf[a-addr], chunk_end-a);
+        cache_mark_dirty(l, off, off + (chunk_end-a) - 1);
+        l->last_used = ++lru_clock;
+
+        a = chunk_end;
+    }
+
+    busy = false;
+    return 0;
+}
+
+static void cache_set_area(eeprom_addr_t addr, uint8_t v, size_t len) {
+    if(len == 0) return;
+
+    // let the driver do the whole range, then keep cached copies in step
+    pw_eeprom_set_area(addr, v, len);
+    cache_patch(addr, 0, 0, v, len);
+}
+
+void pw_eeprom_cache_flush() {
+    if(busy) return;
+    busy = true;
+
+    // write back in address order so the driver sees sequential pages
+    uint16_t last = 0;
+    bool first = true;
+    while(true) {
+        cache_line_t *next = 0;
+        for(size_t i = 0; i < PW_EEPROM_CACHE_PAGES; i++) {
+            cache_line_t *l = &lines[i];
+            if(!l->valid || !l->dirty) continue;
+            if(!first && l->page <= last) continue;
+            if(!next || l->page < next->page) next = l;
+        }
+        if(!next) break;
+
+        cache_writeback(next);
+        last = next->page;
+        first = false;
+    }
+
+    busy = false;
+}
+
+/*
+ *  Write back dirty lines in [addr, addr+len), and drop them too if
+ *  `drop` is set. For anything that is about to access the eeprom
+ *  behind the cache's back.
+ */
+static void cache_sync(eeprom_addr_t addr, size_t len, bool drop) {
+    if(busy) return;
+    busy = true;
+
+    uint32_t end = (uint32_t)addr + len;
+    for(size_t i = 0; i < PW_EEPROM_CACHE_PAGES; i++) {
+        cache_line_t *l = &lines[i];
+        if(!l->valid) continue;
+        if(PAGE_ADDR(l->page+1) <= addr || PAGE_ADDR(l->page) >= end) continue;
+
+        cache_writeback(l);
+        if(drop) l->valid = 0;
+    }
+
+    busy = false;
+}
+
+void pw_eeprom_cache_invalidate() {
+    pinned_valid = 0;
+    pw_eeprom_cache_flush();
+    for(size_t i = 0; i < PW_EEPROM_CACHE_PAGES; i++) {
+        lines[i].valid = 0;
+        lines[i].dirty = 0;
+    }
+}
+
+#else /* PW_EEPROM_CACHE_PAGES > 0 */
+
+static int cache_read(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    stats.bypass_bytes += len;
+    return pw_eeprom_read(addr, buf, len);
+}
+
+static int cache_write(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    stats.bypass_bytes += len;
+    return pw_eeprom_write(addr, buf, len);
+}
+
+static void cache_set_area(eeprom_addr_t addr, uint8_t v, size_t len) {
+    pw_eeprom_set_area(addr, v, len);
+}
+
+void pw_eeprom_cache_flush() {
+}
+
+static void cache_sync(eeprom_addr_t addr, size_t len, bool drop) {
+}
+
+void pw_eeprom_cache_invalidate() {
+    pinned_valid = 0;
+}
+
+#endif /* PW_EEPROM_CACHE_PAGES > 0 */
+
+/*
+ *  Pinned region holding all of [addr, addr+len), or -1.
+ */
+static int pinned_find(eeprom_addr_t addr, size_t len) {
+    for(size_t i = 0; i < N_PINNED; i++) {
+        if(addr >= pinned[i].addr && (uint32_t)addr+len <= (uint32_t)pinned[i].addr+pinned[i].len)
+            return (int)i;
+    }
+    return -1;
+}
+
+/*
+ *  Bring pinned copies in line with a write to [addr, addr+len). `src`
+ *  is the new data, or 0 for a fill with `v`. Regions not loaded yet
+ *  are left alone, they pick the write up when they are.
+ */
+static void pinned_patch(eeprom_addr_t addr, uint8_t *src, uint8_t v, size_t len) {
+    uint32_t end = (uint32_t)addr + len;
+
+    for(size_t i = 0; i < N_PINNED; i++) {
+        const pinned_region_t *p = &pinned[i];
+        uint32_t lo = p->addr, hi = lo + p->len;
+
+        if(!(pinned_valid & (1u<<i))) continue;
+        if(hi <= addr || lo >= end) continue;
+        if(lo < addr) lo = addr;
+        if(hi > end) hi = end;
+
+        if(src) {
+            memcpy(&pinned_data[p->off+lo-p->addr], &src[lo-addr], hi-lo);
+        } else {
+            memset(&pinned_data[p->off+lo-p->addr], v, hi-lo);
+        }
+    }
+}
+
+static void pinned_drop(eeprom_addr_t addr, size_t len) {
+    uint32_t end = (uint32_t)addr + len;
+
+    for(size_t i = 0; i < N_PINNED; i++) {
+        if(pinned[i].addr < end && (uint32_t)pinned[i].addr+pinned[i].len > addr)
+            pinned_valid &= ~(1u<<i);
+    }
+}
+
+/*
+ *  Lazily erased pages read as zeros and get wiped before a write,
+ *  see eeprom_erase.h. Addresses are canonical up to here and physical
+ *  below, see eeprom_bank.h
+ */
+static int mapped_read(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    int r = 0;
+
+    for(size_t off = 0, n; off < len; off += n) {
+        eeprom_addr_t phys;
+        n = pw_eeprom_bank_map(addr+off, len-off, &phys);
+        r |= cache_read(phys, &buf[off], n);
+    }
+    pw_eeprom_erase_filter_read(addr, buf, len);
+
+    return r;
+}
+
+int pw_eeprom_cache_read(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    pw_eeprom_async_fence(addr, len, false);
+
+    int i = pinned_find(addr, len);
+
+    if(i < 0) return mapped_read(addr, buf, len);
+
+    const pinned_region_t *p = &pinned[i];
+    if(!(pinned_valid & (1u<<i))) {
+        int r = mapped_read(p->addr, &pinned_data[p->off], p->len);
+        if(r != 0) return mapped_read(addr, buf, len);
+        pinned_valid |= 1u<<i;
+    }
+
+    memcpy(buf, &pinned_data[p->off+addr-p->addr], len);
+    pw_eeprom_erase_filter_read(addr, buf, len);
+    stats.pinned_hits++;
+
+    return 0;
+}
+
+/*
+ *  Read a list of segments. Segments given in address order that are at
+ *  most PW_EEPROM_READV_GAP apart are joined, as long as the whole run
+ *  fits in a page, and read as one piece.
+ */
+int pw_eeprom_cache_readv(const pw_eeprom_seg_t *segs, size_t n) {
+    uint8_t span[PW_EEPROM_PAGE_SIZE];
+    size_t first = 0;
+    int r = 0;
+
+    while(first < n) {
+        uint32_t start = segs[first].addr, end = start + segs[first].len;
+        size_t last = first+1;
+
+        while(last < n) {
+            uint32_t a = segs[last].addr, e = a + segs[last].len;
+            if(a < end || a-end > PW_EEPROM_READV_GAP || e-start > sizeof(span)) break;
+            end = e;
+            last++;
+        }
+
+        if(last == first+1) {
+            r |= pw_eeprom_cache_read(segs[first].addr, segs[first].buf, segs[first].len);
+        } else {
+            r |= pw_eeprom_cache_read(start, span, end-start);
+            for(size_t i = first; i < last; i++)
+                memcpy(segs[i].buf, &span[segs[i].addr-start], segs[i].len);
+        }
+
+        first = last;
+    }
+
+    return r;
+}
+
+int pw_eeprom_cache_write(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    int r = 0;
+
+    pw_eeprom_async_fence(addr, len, true);
+    pw_eeprom_erase_claim(addr, len);
+    for(size_t off = 0, n; off < len; off += n) {
+        eeprom_addr_t phys;
+        n = pw_eeprom_bank_map(addr+off, len-off, &phys);
+        r |= cache_write(phys, &buf[off], n);
+    }
+    pinned_patch(addr, buf, 0, len);
+
+    return r;
+}
+
+void pw_eeprom_cache_set_area(eeprom_addr_t addr, uint8_t v, size_t len) {
+    pw_eeprom_async_fence(addr, len, true);
+    pw_eeprom_erase_claim(addr, len);
+    for(size_t off = 0, n; off < len; off += n) {
+        eeprom_addr_t phys;
+        n = pw_eeprom_bank_map(addr+off, len-off, &phys);
+        cache_set_area(phys, v, n);
+    }
+    pinned_patch(addr, 0, v, len);
+}
+
+void pw_eeprom_cache_sync(eeprom_addr_t addr, size_t len, bool drop) {
+    for(size_t off = 0, n; off < len; off += n) {
+        eeprom_addr_t phys;
+        n = pw_eeprom_bank_map(addr+off, len-off, &phys);
+        cache_sync(phys, n, drop);
+    }
+    if(drop) pinned_drop(addr, len);
+}
+
+void pw_eeprom_cache_get_stats(pw_eeprom_cache_stats_t *s) {
+    *s = stats;
+}
+
+void pw_eeprom_cache_reset_stats() {
+    stats = (pw_eeprom_cache_stats_t) {
+        0
+    };
+}
+
+void pw_eeprom_cache_print_stats() {
+    uint32_t reads = stats.read_hits + stats.read_misses;
+    uint32_t writes = stats.write_hits + stats.write_misses;
+
+    printf("eeprom cache: %u pages of %u bytes\n", PW_EEPROM_CACHE_PAGES, PW_EEPROM_PAGE_SIZE);
+    printf("  read  hits %u / %u (%u%%)\n", stats.read_hits, reads,
+           reads?(100*stats.read_hits/reads):0);
+    printf("  write hits %u / %u (%u%%)\n", stats.write_hits, writes,
+           writes?(100*stats.write_hits/writes):0);
+    printf("  fills %u, writebacks %u, bypassed %u bytes\n",
+           stats.fills, stats.writebacks, stats.bypass_bytes);
+    printf("  pinned hits %u\n", stats.pinned_hits);
+}
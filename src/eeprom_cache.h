@@ -0,0 +1,103 @@
+#ifndef PW_EEPROM_CACHE_H
+#define PW_EEPROM_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "eeprom.h"
+
+/// @file eeprom_cache.h
+
+/*
+ *  Write-back page cache between the core and the eeprom driver.
+ *
+ *  Core code reads and writes eeprom through `pw_eeprom_cache_*()`
+ *  instead of the driver functions. Pages are PW_EEPROM_PAGE_SIZE bytes
+ *  and evicted least-recently-used first. Writes stay in RAM until the
+ *  page is evicted or `pw_eeprom_cache_flush()` is called; walker_loop()
+ *  flushes at the end of every iteration.
+ *
+ *  Accesses longer than PW_EEPROM_CACHE_BYPASS_LEN don't allocate pages,
+ *  so one big transfer doesn't throw out the images a screen redraws.
+ *
+ *  A call that interrupts another cache call (e.g. from a button
+ *  handler) goes straight to the driver and only patches pages that
+ *  are already cached.
+ *
+ *  A few small records the game polls during a connection (identity,
+ *  health, the watts at 0xce8a) are pinned: kept in RAM for good and
+ *  updated by every write, so reads of them never reach the driver.
+ *
+ *  Define PW_EEPROM_CACHE_PAGES as 0 to pass everything else straight
+ *  through.
+ */
+
+#ifndef PW_EEPROM_CACHE_PAGES
+#define PW_EEPROM_CACHE_PAGES   16
+#endif
+
+#ifndef PW_EEPROM_PAGE_SIZE
+#define PW_EEPROM_PAGE_SIZE     128
+#endif
+
+#ifndef PW_EEPROM_CACHE_BYPASS_LEN
+#define PW_EEPROM_CACHE_BYPASS_LEN  (PW_EEPROM_CACHE_PAGES*PW_EEPROM_PAGE_SIZE/2)
+#endif
+
+#ifndef PW_EEPROM_READV_GAP
+#define PW_EEPROM_READV_GAP     32  // bytes read and thrown away to join two segments
+#endif
+
+/*
+ *  One piece of a scattered read, see `pw_eeprom_cache_readv()`.
+ */
+typedef struct {
+    eeprom_addr_t addr;
+    uint16_t len;
+    uint8_t *buf;
+} pw_eeprom_seg_t;
+
+typedef struct {
+    uint32_t read_hits;     // pages served from RAM
+    uint32_t read_misses;   // pages fetched from the driver
+    uint32_t write_hits;    // pages written in RAM only
+    uint32_t write_misses;  // pages that had to be allocated for a write
+    uint32_t fills;         // driver reads to fill a page
+    uint32_t writebacks;    // driver writes of dirty pages
+    uint32_t bypass_bytes;  // bytes that went straight to the driver
+    uint32_t pinned_hits;   // reads served from a pinned region
+} pw_eeprom_cache_stats_t;
+
+int pw_eeprom_cache_read(eeprom_addr_t addr, uint8_t *buf, size_t len);
+int pw_eeprom_cache_readv(const pw_eeprom_seg_t *segs, size_t n);
+int pw_eeprom_cache_write(eeprom_addr_t addr, uint8_t *buf, size_t len);
+void pw_eeprom_cache_set_area(eeprom_addr_t addr, uint8_t v, size_t len);
+void pw_eeprom_cache_flush();
+void pw_eeprom_cache_sync(eeprom_addr_t addr, size_t len, bool drop);
+void pw_eeprom_cache_invalidate();
+
+void pw_eeprom_cache_get_stats(pw_eeprom_cache_stats_t *stats);
+void pw_eeprom_cache_reset_stats();
+void pw_eeprom_cache_print_stats();
+
+#if defined(PW_INSTRUMENT) && !defined(PW_EEPROM_CACHE_INTERNAL)
+#include "instrument.h"
+
+/*
+ *  Charge the driver traffic caused by a cache call to whoever called
+ *  the cache, not to eeprom_cache.c.
+ */
+#define pw_eeprom_cache_read(addr, buf, len) \
+    (pw_instr_enter(PW_INSTR_HERE), pw_instr_leave(pw_eeprom_cache_read(addr, buf, len)))
+#define pw_eeprom_cache_readv(segs, n) \
+    (pw_instr_enter(PW_INSTR_HERE), pw_instr_leave(pw_eeprom_cache_readv(segs, n)))
+#define pw_eeprom_cache_write(addr, buf, len) \
+    (pw_instr_enter(PW_INSTR_HERE), pw_instr_leave(pw_eeprom_cache_write(addr, buf, len)))
+#define pw_eeprom_cache_set_area(addr, v, len) \
+    (pw_instr_enter(PW_INSTR_HERE), pw_eeprom_cache_set_area(addr, v, len), (void)pw_instr_leave(0))
+#define pw_eeprom_cache_flush() \
+    (pw_instr_enter(PW_INSTR_HERE), pw_eeprom_cache_flush(), (void)pw_instr_leave(0))
+#endif /* PW_INSTRUMENT */
+
+#endif /* PW_EEPROM_CACHE_H */
@@ -0,0 +1,252 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "eeprom_erase.h"
+#include "eeprom_cache.h"
+#include "eeprom_map.h"
+#include "eeprom.h"
+
+/// @file eeprom_erase.c
+
+typedef struct {
+    eeprom_addr_t addr;
+    uint16_t size;
+} erase_region_t;
+
+/*
+ *  Keep these sorted by address. One bitmap bit per eeprom page each
+ *  region touches, 8*PW_EEPROM_SIZE_ERASE_PENDING bits at most.
+ */
+static const erase_region_t regions[] = {
+    {PW_EEPROM_ADDR_RECEIVED_BITFIELD, 0x6c8},
+    {0xce80, 0xd4c},    // caught pokemon, historic steps, event log
+    {PW_EEPROM_ADDR_MET_PEER_DATA, PW_EEPROM_SIZE_MET_PEER_DATA},
+};
+#define N_REGIONS   (sizeof(regions)/sizeof(regions[0]))
+
+#define PAGE_OF(a)      ((uint32_t)(a)/PW_EEPROM_PAGE_SIZE)
+#define PAGE_ADDR(p)    ((uint32_t)(p)*PW_EEPROM_PAGE_SIZE)
+
+static uint8_t pending[PW_EEPROM_SIZE_ERASE_PENDING];
+static uint8_t saved[PW_EEPROM_SIZE_ERASE_PENDING];
+static size_t n_pending = 0;
+static bool n_saved_nonzero = false;
+static bool in_erase = false;
+
+static inline bool bit_get(const uint8_t *bm, size_t b) {
+    return bm[b/8] & (1u<<(b%8));
+}
+
+static size_t region_chunks(const erase_region_t *r) {
+    return PAGE_OF(r->addr+r->size-1) - PAGE_OF(r->addr) + 1;
+}
+
+/*
+ *  Find the region chunk (page-sized piece of a region) holding `a`.
+ *  Returns its bitmap bit and range, or -1 if `a` isn't in a region.
+ */
+static int chunk_at(uint32_t a, uint32_t *cs, uint32_t *ce) {
+    size_t bit = 0;
+
+    for(size_t i = 0; i < N_REGIONS; i++) {
+        const erase_region_t *r = &regions[i];
+        uint32_t r_end = (uint32_t)r->addr + r->size;
+
+        if(a >= r->addr && a < r_end) {
+            uint32_t page = PAGE_OF(a);
+            *cs = (PAGE_ADDR(page) > r->addr)?PAGE_ADDR(page):r->addr;
+            *ce = (PAGE_ADDR(page+1) < r_end)?PAGE_ADDR(page+1):r_end;
+            return (int)(bit + page - PAGE_OF(r->addr));
+        }
+        bit += region_chunks(r);
+    }
+
+    return -1;
+}
+
+/*
+ *  Start of the first region after `a`, or 0x10000.
+ */
+static uint32_t next_region(uint32_t a) {
+    for(size_t i = 0; i < N_REGIONS; i++)
+        if(regions[i].addr > a) return regions[i].addr;
+    return 0x10000;
+}
+
+static void pending_set(size_t b) {
+    if(bit_get(pending, b)) return;
+    pending[b/8] |= 1u<<(b%8);
+    n_pending++;
+}
+
+static void pending_clear(size_t b) {
+    if(!bit_get(pending, b)) return;
+    pending[b/8] &= ~(1u<<(b%8));
+    n_pending--;
+}
+
+static void save_pending() {
+    memcpy(saved, pending, sizeof(saved));
+    n_saved_nonzero = n_pending > 0;
+
+    in_erase = true;
+    pw_eeprom_reliable_write(
+        PW_EEPROM_ADDR_ERASE_PENDING_1,
+        PW_EEPROM_ADDR_ERASE_PENDING_2,
+        saved,
+        PW_EEPROM_SIZE_ERASE_PENDING
+    );
+    in_erase = false;
+}
+
+static void wipe_chunk(size_t b, uint32_t cs, uint32_t ce) {
+    pending_clear(b);
+
+    in_erase = true;
+    pw_eeprom_cache_set_area(cs, 0, ce-cs);
+    in_erase = false;
+}
+
+void pw_eeprom_erase_init() {
+    int r = pw_eeprom_reliable_read(
+                PW_EEPROM_ADDR_ERASE_PENDING_1,
+                PW_EEPROM_ADDR_ERASE_PENDING_2,
+                pending,
+                PW_EEPROM_SIZE_ERASE_PENDING
+            );
+
+    size_t n_bits = 0;
+    for(size_t i = 0; i < N_REGIONS; i++)
+        n_bits += region_chunks(&regions[i]);
+
+    n_pending = 0;
+    for(size_t b = 0; b < 8*sizeof(pending); b++) {
+        if(b >= n_bits || r < 0) {
+            pending[b/8] &= ~(1u<<(b%8));
+        } else if(bit_get(pending, b)) {
+            n_pending++;
+        }
+    }
+
+    // first boot, or the record got lost: start from a valid empty one
+    if(r < 0) {
+        save_pending();
+    } else {
+        memcpy(saved, pending, sizeof(saved));
+        n_saved_nonzero = n_pending > 0;
+    }
+}
+
+/*
+ *  Zero [addr, addr+len). Whole region pages are only marked, the rest
+ *  is zeroed now.
+ */
+void pw_eeprom_erase_lazy(eeprom_addr_t addr, size_t len) {
+    uint32_t a = addr, end = (uint32_t)addr + len;
+    bool marked = false;
+
+    while(a < end) {
+        uint32_t cs, ce, next;
+        int b = chunk_at(a, &cs, &ce);
+
+        if(b >= 0 && cs >= addr && ce <= end) {
+            pending_set(b);
+            marked = true;
+            a = ce;
+            continue;
+        }
+
+        next = (b >= 0)?ce:next_region(a);
+        if(next > end) next = end;
+        pw_eeprom_cache_set_area(a, 0, next-a);
+        a = next;
+    }
+
+    if(marked) save_pending();
+}
+
+/*
+ *  Wipe one pending page. Returns false when there was nothing to do.
+ */
+bool pw_eeprom_erase_idle() {
+    if(n_pending == 0) return false;
+
+    size_t bit = 0;
+    for(size_t i = 0; i < N_REGIONS; i++) {
+        const erase_region_t *r = &regions[i];
+        size_t n = region_chunks(r);
+
+        for(size_t c = 0; c < n; c++, bit++) {
+            if(!bit_get(pending, bit)) continue;
+
+            uint32_t cs, ce;
+            chunk_at((c == 0)?r->addr:PAGE_ADDR(PAGE_OF(r->addr)+c), &cs, &ce);
+            wipe_chunk(bit, cs, ce);
+
+            if(n_pending == 0) save_pending();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool pw_eeprom_erase_pending() {
+    return n_pending > 0;
+}
+
+/*
+ *  Pending pages read as zeros.
+ */
+void pw_eeprom_erase_filter_read(eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    if(n_pending == 0) return;
+
+    uint32_t a = addr, end = (uint32_t)addr + len;
+    while(a < end) {
+        uint32_t cs, ce;
+        int b = chunk_at(a, &cs, &ce);
+
+        if(b < 0) {
+            a = next_region(a);
+            continue;
+        }
+
+        uint32_t e = (ce < end)?ce:end;
+        if(bit_get(pending, b))
+            memset(&buf[a-addr], 0, e-a);
+        a = e;
+    }
+}
+
+/*
+ *  [addr, addr+len) is about to be written. Wipe any pending page there
+ *  first, and make sure the saved bitmap no longer calls it pending
+ *  before the new data can reach the eeprom.
+ */
+void pw_eeprom_erase_claim(eeprom_addr_t addr, size_t len) {
+    if(in_erase || !n_saved_nonzero) return;
+
+    uint32_t a = addr, end = (uint32_t)addr + len;
+    bool stale = false;
+
+    while(a < end) {
+        uint32_t cs, ce;
+        int b = chunk_at(a, &cs, &ce);
+
+        if(b < 0) {
+            a = next_region(a);
+            continue;
+        }
+
+        if(bit_get(pending, b)) wipe_chunk(b, cs, ce);
+        if(bit_get(saved, b)) stale = true;
+        a = ce;
+    }
+
+    if(stale) {
+        save_pending();
+        pw_eeprom_cache_flush();
+    }
+}
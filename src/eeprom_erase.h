@@ -0,0 +1,43 @@
+#ifndef PW_EEPROM_ERASE_H
+#define PW_EEPROM_ERASE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "eeprom.h"
+#include "eeprom_map.h"
+
+/// @file eeprom_erase.h
+
+/*
+ *  Lazy zeroing of the big log/history regions.
+ *
+ *  `pw_eeprom_erase_lazy()` only marks the eeprom pages of a region as
+ *  pending. From then on `pw_eeprom_cache_read()` returns zeros for them,
+ *  and `pw_eeprom_erase_idle()` (one page per walker_loop()) does the
+ *  actual wipe. A write into a pending page wipes that page first.
+ *
+ *  The pending bitmap is kept in reliable format in the unused bytes
+ *  after the copy markers, so a wipe interrupted by a reset carries on
+ *  at the next boot. It is only saved when regions are marked, when the
+ *  last page is done, and before data lands on a page the saved bitmap
+ *  still calls pending.
+ *
+ *  Only the regions in the table in eeprom_erase.c are lazy, anything
+ *  else, and the parts of pages a range only partly covers, is zeroed
+ *  straight away as before.
+ */
+
+void pw_eeprom_erase_init();
+void pw_eeprom_erase_lazy(eeprom_addr_t addr, size_t len);
+bool pw_eeprom_erase_idle();
+bool pw_eeprom_erase_pending();
+
+/*
+ *  Hooks for eeprom_cache.c
+ */
+void pw_eeprom_erase_filter_read(eeprom_addr_t addr, uint8_t *buf, size_t len);
+void pw_eeprom_erase_claim(eeprom_addr_t addr, size_t len);
+
+#endif /* PW_EEPROM_ERASE_H */
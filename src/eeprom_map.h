@@ -30,8 +30,12 @@
 #define PW_EEPROM_ADDR_HEALTH_DATA_CHK_1 (PW_EEPROM_ADDR_HEALTH_DATA_1+PW_EEPROM_SIZE_HEALTH_DATA_1)
 #define PW_EEPROM_ADDR_COPY_MARKER_1 0x016f  // struct copymarker. used at walk init time (reliable data format, copy at 0x26f)
 //#define PW_EEPROM_SIZE_COPY_MARKER_1 3 // TODO: dmitry typo? copy marker only 1 byte
-//#define PW_EEPROM_ADDR_0x0172 0x0172  // unused
-//#define PW_EEPROM_SIZE_0x0172 14    // TODO: dmitry typo, should be 16 bytes?
+#define PW_EEPROM_ADDR_ERASE_PENDING_1 0x0172  // unused by the game. picowalker lazy erase bitmap, 85 bits used, see eeprom_erase.h (reliable data format, copy at 0x0272)
+#define PW_EEPROM_SIZE_ERASE_PENDING 11
+#define PW_EEPROM_ADDR_ERASE_PENDING_CHK_1 (PW_EEPROM_ADDR_ERASE_PENDING_1+PW_EEPROM_SIZE_ERASE_PENDING)
+#define PW_EEPROM_ADDR_BANK_SELECT_1 0x017e  // unused by the game. picowalker live route bank, see eeprom_bank.h (reliable data format, copy at 0x027e)
+#define PW_EEPROM_SIZE_BANK_SELECT 1
+#define PW_EEPROM_ADDR_BANK_SELECT_CHK_1 (PW_EEPROM_ADDR_BANK_SELECT_1+PW_EEPROM_SIZE_BANK_SELECT)
 #define PW_EEPROM_ADDR_FACTORY_DATA_2 0x0180  // factory-provided adc calibration data. (reliable data format, copy at 0x0080)
 #define PW_EEPROM_SIZE_FACTORY_DATA_2 2
 #define PW_EEPROM_ADDR_FACTORY_DATA_CHK_2 (PW_EEPROM_ADDR_FACTORY_DATA_2+PW_EEPROM_SIZE_FACTORY_DATA_2)
@@ -49,8 +53,10 @@
 #define PW_EEPROM_ADDR_HEALTH_DATA_CHK_2 (PW_EEPROM_ADDR_HEALTH_DATA_2+PW_EEPROM_SIZE_HEALTH_DATA_2)
 #define PW_EEPROM_ADDR_COPY_MARKER_2 0x026f  // struct copymarker. used at walk init time (reliable data format, copy at 0x16f)
 //#define PW_EEPROM_SIZE_COPY_MARKER_2 3
-#define PW_EEPROM_ADDR_0x0272 0x0272  // unused
-#define PW_EEPROM_SIZE_0x0272 14    // TODO: Same issues as above
+#define PW_EEPROM_ADDR_ERASE_PENDING_2 0x0272  // unused by the game. picowalker lazy erase bitmap, see eeprom_erase.h (reliable data format, copy at 0x0172)
+#define PW_EEPROM_ADDR_ERASE_PENDING_CHK_2 (PW_EEPROM_ADDR_ERASE_PENDING_2+PW_EEPROM_SIZE_ERASE_PENDING)
+#define PW_EEPROM_ADDR_BANK_SELECT_2 0x027e  // unused by the game. picowalker live route bank, see eeprom_bank.h (reliable data format, copy at 0x017e)
+#define PW_EEPROM_ADDR_BANK_SELECT_CHK_2 (PW_EEPROM_ADDR_BANK_SELECT_2+PW_EEPROM_SIZE_BANK_SELECT)
 #define PW_EEPROM_ADDR_IMG_DIGITS 0x0280  // numeric character images: "0123456789:-/", 8x16 each, in this order
 #define PW_EEPROM_SIZE_IMG_DIGITS 416
 #define PW_EEPROM_SIZE_IMG_CHAR         32
@@ -109,8 +115,8 @@
 #define PW_EEPROM_SIZE_IMG_MENU_ARROW_RIGHT 32
 #define PW_EEPROM_ADDR_IMG_MENU_ARROW_RETURN 0x05f8  // "return" symbol for menu 8x16
 #define PW_EEPROM_SIZE_IMG_MENU_ARROW_RETURN 32
-//#define PW_EEPROM_ADDR_0x0618 0x0618  // unused
-//#define PW_EEPROM_SIZE_0x0618 40
+#define PW_EEPROM_ADDR_HEALTH_JOURNAL_0 0x0618  // unused by the game. picowalker steps/watts journal, page 1 of 3, see health_journal.h
+#define PW_EEPROM_SIZE_HEALTH_JOURNAL_0 40
 #define PW_EEPROM_ADDR_0x0638 0x0638  // symbol for "have more message" in the bottom right of messages. orred into last 8 columns (thus 16 bytes). applied after 0x0648
 #define PW_EEPROM_SIZE_0x0638 16
 #define PW_EEPROM_ADDR_0x0648 0x0648  // symbol for "have more messages" in the bottom right of messages. each byte here is anded with each col of last 8 in the message. both bitplanes (so you can make it black or keep as is). applied before 0x0638
@@ -439,8 +445,8 @@
 #define PW_EEPROM_SIZE_EVENT_ITEM 8
 #define PW_EEPROM_ADDR_TEXT_EVENT_ITEM_NAME 0xbd48  // item name image 96x16
 #define PW_EEPROM_SIZE_TEXT_EVENT_ITEM_NAME 384
-//#define PW_EEPROM_ADDR_0xbec8 0xbec8  // unused
-//#define PW_EEPROM_SIZE_0xbec8 56
+#define PW_EEPROM_ADDR_HEALTH_JOURNAL_1 0xbec8  // unused by the game. picowalker steps/watts journal, page 2 of 3, see health_journal.h
+#define PW_EEPROM_SIZE_HEALTH_JOURNAL_1 56
 // TODO: multiple columns
 #define PW_EEPROM_ADDR_SPECIAL_ROUTE_STRUCT 0xbf00  // "special route" info (struct specialroute):
 #define PW_EEPROM_SIZE_SPECIAL_ROUTE_STRUCT 3260
@@ -480,8 +486,8 @@
 #define PW_EEPROM_SIZE_TEXT_SPECIAL_ROUTE_NAME_SMALL 320
 #define PW_EEPROM_ADDR_TEXT_SPECIAL_ROUTE_NAME 0xca3c  // special route item textual name 96x16
 #define PW_EEPROM_SIZE_TEXT_SPECIAL_ROUTE_NAME 384
-//#define PW_EEPROM_ADDR_0xcbbc 0xcbbc  // unused
-//#define PW_EEPROM_SIZE_0xcbbc 68
+#define PW_EEPROM_ADDR_HEALTH_JOURNAL_2 0xcbbc  // unused by the game. picowalker steps/watts journal, page 3 of 3, see health_journal.h
+#define PW_EEPROM_SIZE_HEALTH_JOURNAL_2 68
 #define PW_EEPROM_ADDR_TEAM_DATA_STRUCT 0xcc00  // struct teamdata on our whole team, so that any walkers we peer play with transfer it to their ds game and we can be battled in the trainer house
 #define PW_EEPROM_SIZE_TEAM_DATA_STRUCT 548
 //#define PW_EEPROM_ADDR_0xce24 0xce24  // also written at walk start time as part of the above. probably just to keep the write a multiple of 0x80 bytes
@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "screen.h"
+#include "framebuffer.h"
+
+/// @file framebuffer.c
+
+#ifdef PW_SCREEN_FRAMEBUFFER
+
+static uint8_t fb[PW_FB_STRIPS][SCREEN_WIDTH][2];
+
+/*
+ *  Dirty columns [x0, x1) per strip, empty when x0 >= x1.
+ *  Start with everything dirty so the first flush clears the LCD.
+ */
+static uint8_t dirty_x0[PW_FB_STRIPS] = {0};
+static uint8_t dirty_x1[PW_FB_STRIPS] = {
+    [0 ... PW_FB_STRIPS-1] = SCREEN_WIDTH
+};
+
+/*
+ *  Replace the `mask` rows of one strip column, only marking it dirty
+ *  if a pixel actually changed.
+ */
+static inline void fb_put(size_t strip, size_t col, uint8_t lo, uint8_t hi, uint8_t mask) {
+    uint8_t *p = fb[strip][col];
+    uint8_t new_lo = (p[0] & ~mask) | (lo & mask);
+    uint8_t new_hi = (p[1] & ~mask) | (hi & mask);
+
+    if(new_lo == p[0] && new_hi == p[1]) return;
+
+    p[0] = new_lo;
+    p[1] = new_hi;
+    if(col < dirty_x0[strip]) dirty_x0[strip] = col;
+    if(col+1 > dirty_x1[strip]) dirty_x1[strip] = col+1;
+}
+
+void pw_fb_fill_area(screen_pos_t x, screen_pos_t y, screen_pos_t w, screen_pos_t h, screen_colour_t colour) {
+    size_t x_end = (size_t)x + w, y_end = (size_t)y + h;
+    if(x_end > SCREEN_WIDTH) x_end = SCREEN_WIDTH;
+    if(y_end > SCREEN_HEIGHT) y_end = SCREEN_HEIGHT;
+    if(x >= x_end || y >= y_end) return;
+
+    uint8_t lo = (colour&1)?0xff:0x00;
+    uint8_t hi = (colour&2)?0xff:0x00;
+
+    for(size_t strip = y/8; strip*8 < y_end; strip++) {
+        size_t top = (strip*8 > y)?strip*8:y;
+        size_t bottom = ((strip+1)*8 < y_end)?(strip+1)*8:y_end;
+        uint8_t mask = (uint8_t)(((1u<<(bottom-top))-1) << (top-strip*8));
+
+        for(size_t col = x; col < x_end; col++) {
+            fb_put(strip, col, lo, hi, mask);
+        }
+    }
+}
+
+void pw_fb_clear_area(screen_pos_t x, screen_pos_t y, screen_pos_t width, screen_pos_t height) {
+    pw_fb_fill_area(x, y, width, height, SCREEN_WHITE);
+}
+
+void pw_fb_draw_horiz_line(screen_pos_t x, screen_pos_t y, screen_pos_t len, screen_colour_t colour) {
+    pw_fb_fill_area(x, y, len, 1, colour);
+}
+
+void pw_fb_draw_text_box(screen_pos_t x1, screen_pos_t y1, screen_pos_t w, screen_pos_t h, screen_colour_t colour) {
+    if(w == 0 || h == 0) return;
+
+    pw_fb_fill_area(x1, y1, w, 1, colour);
+    pw_fb_fill_area(x1, y1+h-1, w, 1, colour);
+    pw_fb_fill_area(x1, y1, 1, h, colour);
+    pw_fb_fill_area(x1+w-1, y1, 1, h, colour);
+}
+
+void pw_fb_clear() {
+    pw_fb_fill_area(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_WHITE);
+}
+
+void pw_fb_draw_img(pw_img_t *img, screen_pos_t x, screen_pos_t y) {
+    size_t shift = y%8;
+    size_t n_strips = (img->height+7)/8;
+
+    for(size_t s = 0; s < n_strips; s++) {
+        size_t rows = img->height - 8*s;
+        uint8_t src_mask = (rows >= 8)?0xff:(uint8_t)((1u<<rows)-1);
+        size_t strip = y/8 + s;
+        if(strip >= PW_FB_STRIPS) break;
+
+        for(size_t c = 0; c < img->width && x+c < SCREEN_WIDTH; c++) {
+            size_t idx = 2*(s*img->width + c);
+            if(idx+1 >= img->size) break;
+
+            uint8_t lo = img->data[idx+0];
+            uint8_t hi = img->data[idx+1];
+
+            // image rows straddle two framebuffer strips unless y is aligned
+            fb_put(strip, x+c, lo<<shift, hi<<shift, src_mask<<shift);
+            if(shift && strip+1 < PW_FB_STRIPS) {
+                fb_put(strip+1, x+c, lo>>(8-shift), hi>>(8-shift), src_mask>>(8-shift));
+            }
+        }
+    }
+}
+
+/*
+ *  Send each run of dirty strips whose column spans overlap as one
+ *  rectangle. Strips that don't overlap get their own blit so we don't
+ *  resend clean columns between them.
+ */
+void pw_screen_flush() {
+    size_t s = 0;
+
+    while(s < PW_FB_STRIPS) {
+        if(dirty_x0[s] >= dirty_x1[s]) {
+            s++;
+            continue;
+        }
+
+        uint8_t x0 = dirty_x0[s], x1 = dirty_x1[s];
+        size_t e = s+1;
+        while(e < PW_FB_STRIPS && dirty_x0[e] < x1 && dirty_x1[e] > x0) {
+            if(dirty_x0[e] < x0) x0 = dirty_x0[e];
+            if(dirty_x1[e] > x1) x1 = dirty_x1[e];
+            e++;
+        }
+
+        pw_screen_blit_region(&fb[0][0][0], x0, s*8, x1-x0, (e-s)*8);
+
+        for(; s < e; s++) {
+            dirty_x0[s] = SCREEN_WIDTH;
+            dirty_x1[s] = 0;
+        }
+    }
+}
+
+#else /* PW_SCREEN_FRAMEBUFFER */
+
+void pw_screen_flush() {
+}
+
+#endif /* PW_SCREEN_FRAMEBUFFER */
@@ -0,0 +1,35 @@
+#ifndef PW_FRAMEBUFFER_H
+#define PW_FRAMEBUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "screen.h"
+
+/// @file framebuffer.h
+
+/*
+ *  Optional core-side framebuffer.
+ *
+ *  When the core is built with PW_SCREEN_FRAMEBUFFER, screen.h maps the
+ *  driver drawing functions onto the `pw_fb_*` versions below. They draw
+ *  into a 96x64 2bpp buffer in RAM and remember which columns of each
+ *  8-row strip actually changed. `pw_screen_flush()`, called at the end
+ *  of walker_loop(), sends only those regions to the driver with
+ *  `pw_screen_blit_region()`.
+ *
+ *  The buffer uses the same layout as pw_img_t data: 8-row strips top to
+ *  bottom, two bytes (bitplanes) per column, SCREEN_WIDTH columns each.
+ */
+
+#define PW_FB_STRIPS    (SCREEN_HEIGHT/8)
+#define PW_FB_SIZE      (SCREEN_WIDTH*SCREEN_HEIGHT/4)
+
+void pw_fb_draw_img(pw_img_t *img, screen_pos_t x, screen_pos_t y);
+void pw_fb_clear_area(screen_pos_t x, screen_pos_t y, screen_pos_t width, screen_pos_t height);
+void pw_fb_draw_horiz_line(screen_pos_t x, screen_pos_t y, screen_pos_t len, screen_colour_t colour);
+void pw_fb_draw_text_box(screen_pos_t x1, screen_pos_t y1, screen_pos_t w, screen_pos_t h, screen_colour_t colour);
+void pw_fb_clear();
+void pw_fb_fill_area(screen_pos_t x, screen_pos_t y, screen_pos_t w, screen_pos_t h, screen_colour_t colour);
+
+#endif /* PW_FRAMEBUFFER_H */
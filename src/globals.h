@@ -8,8 +8,7 @@
 /// @file globals.h
 
 #define EEPROM_BUF_SIZE         0x300   // largest image to read is 96x32=0x300 bytes
-#define DECOMPRESSION_BUF_SIZE  (2*EEPROM_BUF_SIZE)
-//#define DECOMPRESSION_BUF_SIZE  0x100
+#define DECOMPRESSION_BUF_SIZE  0x100   // scratch, ir writes decompress straight into eeprom pages
 #define PACKET_BUF_SIZE         0x88
 
 
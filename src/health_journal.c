@@ -0,0 +1,206 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "health_journal.h"
+#include "eeprom_cache.h"
+#include "eeprom_map.h"
+#include "eeprom.h"
+#include "globals.h"
+#include "accel.h"
+#include "timer.h"
+#include "types.h"
+#include "utils.h"
+
+/// @file health_journal.c
+
+/*
+ *  Journal record, PW_HEALTH_JOURNAL_RECORD_SIZE bytes, little endian:
+ *  [0] generation
+ *  [1] sequence number
+ *  [2..4] today_steps - committed today_steps
+ *  [5..6] current_watts
+ *  [7] steps_this_watt
+ *  [8] checksum, as for reliable data
+ */
+
+static health_data_t base;      // what the canonical slots hold, host order
+static uint8_t gen = 0;
+static uint8_t seq = 0;
+static uint8_t slot = 0;
+static bool base_valid = false;
+static bool dirty = false;
+static uint64_t last_append = 0;
+
+static const eeprom_addr_t journal_pages[PW_HEALTH_JOURNAL_PAGES] = {
+    PW_EEPROM_ADDR_HEALTH_JOURNAL_0,
+    PW_EEPROM_ADDR_HEALTH_JOURNAL_1,
+    PW_EEPROM_ADDR_HEALTH_JOURNAL_2,
+};
+
+/*
+ *  Slot `s` is on page s%PAGES, so consecutive records never share one.
+ */
+static eeprom_addr_t slot_addr(size_t s) {
+    return journal_pages[s%PW_HEALTH_JOURNAL_PAGES] + (s/PW_HEALTH_JOURNAL_PAGES)*PW_HEALTH_JOURNAL_RECORD_SIZE;
+}
+
+/*
+ *  All slots, in slot order.
+ */
+static void journal_read(uint8_t *journal) {
+    pw_eeprom_seg_t segs[PW_HEALTH_JOURNAL_SLOTS];
+
+    for(size_t s = 0; s < PW_HEALTH_JOURNAL_SLOTS; s++) {
+        segs[s] = (pw_eeprom_seg_t) {
+            slot_addr(s), PW_HEALTH_JOURNAL_RECORD_SIZE, &journal[s*PW_HEALTH_JOURNAL_RECORD_SIZE]
+        };
+    }
+    pw_eeprom_cache_readv(segs, PW_HEALTH_JOURNAL_SLOTS);
+}
+
+static uint8_t record_checksum(const uint8_t *rec) {
+    uint8_t c = 1;
+    for(size_t i = 0; i < PW_HEALTH_JOURNAL_RECORD_SIZE-1; i++)
+        c += rec[i];
+    return c;
+}
+
+static bool gen_in_use(const uint8_t *journal, uint8_t g) {
+    for(size_t i = 0; i < PW_HEALTH_JOURNAL_SLOTS; i++) {
+        const uint8_t *rec = &journal[i*PW_HEALTH_JOURNAL_RECORD_SIZE];
+        if(rec[0] == g && rec[PW_HEALTH_JOURNAL_RECORD_SIZE-1] == record_checksum(rec)) return true;
+    }
+    return false;
+}
+
+static void health_swap(health_data_t *h) {
+    h->total_steps   = swap_bytes_u32(h->total_steps);
+    h->today_steps   = swap_bytes_u32(h->today_steps);
+    h->last_sync     = swap_bytes_u32(h->last_sync);
+    h->total_days    = swap_bytes_u16(h->total_days);
+    h->current_watts = swap_bytes_u16(h->current_watts);
+}
+
+void pw_health_load() {
+    uint8_t journal[PW_HEALTH_JOURNAL_SLOTS*PW_HEALTH_JOURNAL_RECORD_SIZE];
+
+    int r = pw_eeprom_reliable_read(
+                PW_EEPROM_ADDR_HEALTH_DATA_1,
+                PW_EEPROM_ADDR_HEALTH_DATA_2,
+                (uint8_t*)&health_data_cache,
+                sizeof(health_data_cache)
+            );
+
+    // swap BE in eeprom to LE in host
+    health_swap(&health_data_cache);
+    base = health_data_cache;
+    base_valid = r >= 0;
+    gen = base.padding[0];
+
+    journal_read(journal);
+
+    uint8_t *newest = 0;
+    for(size_t i = 0; i < PW_HEALTH_JOURNAL_SLOTS; i++) {
+        uint8_t *rec = &journal[i*PW_HEALTH_JOURNAL_RECORD_SIZE];
+
+        if(rec[PW_HEALTH_JOURNAL_RECORD_SIZE-1] != record_checksum(rec)) continue;
+        if(rec[0] != gen) continue;
+        if(newest && (int8_t)(rec[1]-newest[1]) <= 0) continue;
+
+        newest = rec;
+        slot = (i+1)%PW_HEALTH_JOURNAL_SLOTS;
+    }
+
+    if(newest) {
+        uint32_t steps = newest[2] | (uint32_t)newest[3]<<8 | (uint32_t)newest[4]<<16;
+
+        health_data_cache.today_steps += steps;
+        if(health_data_cache.today_steps > TODAY_STEPS_MAX) health_data_cache.today_steps = TODAY_STEPS_MAX;
+        health_data_cache.current_watts = newest[5] | (uint16_t)newest[6]<<8;
+        health_data_cache.steps_this_watt = newest[7];
+        seq = newest[1]+1;
+    }
+
+    dirty = false;
+    last_append = pw_now_us();
+}
+
+/*
+ *  Write `health_data_cache` to the canonical slots, which starts a new
+ *  journal generation.
+ */
+void pw_health_commit() {
+    health_data_t be = health_data_cache;
+    uint8_t journal[PW_HEALTH_JOURNAL_SLOTS*PW_HEALTH_JOURNAL_RECORD_SIZE];
+
+    // nothing to do if the slots already hold it
+    if(base_valid && !memcmp(&base, &health_data_cache, sizeof(base))) return;
+
+    // the generation wraps: skip any that old records still carry
+    journal_read(journal);
+    do {
+        gen++;
+    } while(gen_in_use(journal, gen));
+
+    health_data_cache.padding[0] = gen;
+    be.padding[0] = gen;
+    health_swap(&be);
+
+    pw_eeprom_reliable_write(
+        PW_EEPROM_ADDR_HEALTH_DATA_1,
+        PW_EEPROM_ADDR_HEALTH_DATA_2,
+        (uint8_t*)&be,
+        sizeof(be)
+    );
+
+    base = health_data_cache;
+    base_valid = true;
+    dirty = false;
+}
+
+void pw_health_mark_dirty() {
+    dirty = true;
+}
+
+static void append() {
+    uint8_t rec[PW_HEALTH_JOURNAL_RECORD_SIZE];
+    uint32_t steps = health_data_cache.today_steps - base.today_steps;
+
+    rec[0] = gen;
+    rec[1] = seq;
+    rec[2] = steps;
+    rec[3] = steps>>8;
+    rec[4] = steps>>16;
+    rec[5] = health_data_cache.current_watts;
+    rec[6] = health_data_cache.current_watts>>8;
+    rec[7] = health_data_cache.steps_this_watt;
+    rec[8] = record_checksum(rec);
+
+    pw_eeprom_cache_write(slot_addr(slot), rec, sizeof(rec));
+
+    slot = (slot+1)%PW_HEALTH_JOURNAL_SLOTS;
+    seq++;
+}
+
+/*
+ *  Called from walker_loop(). Returns true if a record was written.
+ */
+bool pw_health_idle() {
+    if(!dirty) return false;
+
+    uint64_t now = pw_now_us();
+    if(now - last_append < PW_HEALTH_JOURNAL_INTERVAL_US) return false;
+    last_append = now;
+    dirty = false;
+
+    // steps only go down at a commit, anything else can't be a delta
+    if(health_data_cache.today_steps < base.today_steps) {
+        pw_health_commit();
+    } else {
+        append();
+    }
+
+    return true;
+}
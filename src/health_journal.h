@@ -0,0 +1,58 @@
+#ifndef PW_HEALTH_JOURNAL_H
+#define PW_HEALTH_JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "eeprom_map.h"
+
+/// @file health_journal.h
+
+/*
+ *  Persistence for `health_data_cache`.
+ *
+ *  Steps and watts change every accel sample. Saving them by rewriting
+ *  both reliable copies of the health data would cost two page writes and
+ *  could leave a half-written record behind, so the changes go to a small
+ *  journal instead. Each record holds the steps walked since the last
+ *  commit plus the current watts, and is written at most once per
+ *  PW_HEALTH_JOURNAL_INTERVAL_US and only when something changed.
+ *
+ *  Every record is a write cycle of the page it lands on, so the slots
+ *  are spread over the three pages with spare bytes the game doesn't use
+ *  (0x0618, 0xbec8, 0xcbbc, four slots each), and consecutive records go
+ *  to different pages. That is as far as the free space goes: at the
+ *  default interval each page still takes up to 480 cycles a day, about
+ *  five and a half years for a 1M cycle part.
+ *
+ *  `pw_health_commit()` writes the whole record to the canonical
+ *  reliable slots (big endian, as the game expects). It does that at
+ *  walk start, at reset, when settings change and when the comms apps
+ *  start, so the game can read it from the eeprom during the connection.
+ *  The canonical record keeps a journal generation in padding[0], and
+ *  records only count for the generation they were written in. So a
+ *  commit cut short by a reset leaves either the old record plus its
+ *  journal, or the new record with an empty one.
+ *
+ *  `pw_health_load()` rebuilds `health_data_cache` at boot. It reads the
+ *  canonical record and applies the newest journal record of the same
+ *  generation.
+ */
+
+#define PW_HEALTH_JOURNAL_RECORD_SIZE   9
+#define PW_HEALTH_JOURNAL_PAGES         3
+#define PW_HEALTH_JOURNAL_PAGE_SLOTS    4
+#define PW_HEALTH_JOURNAL_SLOTS         (PW_HEALTH_JOURNAL_PAGES*PW_HEALTH_JOURNAL_PAGE_SLOTS)
+#define PW_HEALTH_JOURNAL_PAGE_SIZE     (PW_HEALTH_JOURNAL_PAGE_SLOTS*PW_HEALTH_JOURNAL_RECORD_SIZE)
+
+#ifndef PW_HEALTH_JOURNAL_INTERVAL_US
+#define PW_HEALTH_JOURNAL_INTERVAL_US   60000000    // 1 min
+#endif
+
+void pw_health_load();
+void pw_health_commit();
+void pw_health_mark_dirty();
+bool pw_health_idle();
+
+#endif /* PW_HEALTH_JOURNAL_H */
@@ -0,0 +1,211 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "instrument.h"
+#include "eeprom.h"
+#include "screen.h"
+#include "timer.h"
+#include "ir/ir.h"
+
+/// @file instrument.c
+
+const char* const PW_INSTR_KIND_NAMES[N_PW_INSTR_KINDS] = {
+    [PW_INSTR_EEPROM_READ]  = "eeprom_read",
+    [PW_INSTR_EEPROM_WRITE] = "eeprom_write",
+    [PW_INSTR_EEPROM_SET]   = "eeprom_set_area",
+    [PW_INSTR_SCREEN_DRAW]  = "screen_draw_img",
+    [PW_INSTR_SCREEN_CLEAR] = "screen_clear_area",
+    [PW_INSTR_SCREEN_BLIT]  = "screen_blit_region",
+    [PW_INSTR_IR_READ]      = "ir_read",
+    [PW_INSTR_IR_WRITE]     = "ir_write",
+};
+
+#ifdef PW_INSTRUMENT
+
+static pw_instr_site_t sites[PW_INSTR_MAX_SITES];
+static size_t n_sites = 0;
+static uint32_t dropped = 0;
+
+static const char *ctx_file, *ctx_func;
+static int ctx_line;
+static uint32_t ctx_depth = 0;
+
+/*
+ *  `func` and `file` come from __func__/__FILE__, so the same call site
+ *  always passes the same pointers and we can compare those directly.
+ *  Linear scan is fine: there are only a few dozen driver call sites.
+ */
+static pw_instr_site_t *instr_site(const char *file, const char *func, int line, pw_instr_kind_t kind) {
+    for(size_t i = 0; i < n_sites; i++) {
+        pw_instr_site_t *s = &sites[i];
+        if(s->line == line && s->func == func && s->kind == kind && s->file == file)
+            return s;
+    }
+
+    if(n_sites >= PW_INSTR_MAX_SITES) {
+        dropped++;
+        return 0;
+    }
+
+    pw_instr_site_t *s = &sites[n_sites++];
+    *s = (pw_instr_site_t) {
+        .file = file,
+        .func = func,
+        .line = line,
+        .kind = kind,
+    };
+    return s;
+}
+
+static void instr_count(const char *file, const char *func, int line,
+                        pw_instr_kind_t kind, size_t bytes, uint64_t start) {
+    uint64_t dt = pw_now_us() - start;
+    if(ctx_depth > 0) {
+        file = ctx_file;
+        func = ctx_func;
+        line = ctx_line;
+    }
+    pw_instr_site_t *s = instr_site(file, func, line, kind);
+    if(!s) return;
+    s->calls++;
+    s->bytes += bytes;
+    s->time_us += dt;
+}
+
+/*
+ *  Wrappers. The parentheses around the driver function name stop the
+ *  function-like macros in the headers from expanding again.
+ */
+int pw_instr_eeprom_read(const char *file, const char *func, int line,
+                         eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    uint64_t t = pw_now_us();
+    int r = (pw_eeprom_read)(addr, buf, len);
+    instr_count(file, func, line, PW_INSTR_EEPROM_READ, len, t);
+    return r;
+}
+
+int pw_instr_eeprom_write(const char *file, const char *func, int line,
+                          eeprom_addr_t addr, uint8_t *buf, size_t len) {
+    uint64_t t = pw_now_us();
+    int r = (pw_eeprom_write)(addr, buf, len);
+    instr_count(file, func, line, PW_INSTR_EEPROM_WRITE, len, t);
+    return r;
+}
+
+void pw_instr_eeprom_set_area(const char *file, const char *func, int line,
+                              eeprom_addr_t addr, uint8_t v, size_t len) {
+    uint64_t t = pw_now_us();
+    (pw_eeprom_set_area)(addr, v, len);
+    instr_count(file, func, line, PW_INSTR_EEPROM_SET, len, t);
+}
+
+#ifdef PW_SCREEN_FRAMEBUFFER
+void pw_instr_screen_blit_region(const char *file, const char *func, int line,
+                                 const uint8_t *fb, screen_pos_t x, screen_pos_t y,
+                                 screen_pos_t width, screen_pos_t height) {
+    uint64_t t = pw_now_us();
+    (pw_screen_blit_region)(fb, x, y, width, height);
+    instr_count(file, func, line, PW_INSTR_SCREEN_BLIT, (size_t)width*height/4, t);
+}
+#else
+void pw_instr_screen_draw_img(const char *file, const char *func, int line,
+                              pw_img_t *img, screen_pos_t x, screen_pos_t y) {
+    uint64_t t = pw_now_us();
+    (pw_screen_draw_img)(img, x, y);
+    instr_count(file, func, line, PW_INSTR_SCREEN_DRAW, img->size, t);
+}
+
+void pw_instr_screen_clear_area(const char *file, const char *func, int line,
+                                screen_pos_t x, screen_pos_t y,
+                                screen_pos_t width, screen_pos_t height) {
+    uint64_t t = pw_now_us();
+    (pw_screen_clear_area)(x, y, width, height);
+    // bytes the LCD would receive in the native 2bpp format
+    instr_count(file, func, line, PW_INSTR_SCREEN_CLEAR, (size_t)width*height/4, t);
+}
+#endif /* PW_SCREEN_FRAMEBUFFER */
+
+int pw_instr_ir_read(const char *file, const char *func, int line, uint8_t *buf, size_t len) {
+    uint64_t t = pw_now_us();
+    int r = (pw_ir_read)(buf, len);
+    instr_count(file, func, line, PW_INSTR_IR_READ, (r > 0)?r:0, t);
+    return r;
+}
+
+int pw_instr_ir_write(const char *file, const char *func, int line, uint8_t *buf, size_t len) {
+    uint64_t t = pw_now_us();
+    int r = (pw_ir_write)(buf, len);
+    instr_count(file, func, line, PW_INSTR_IR_WRITE, (r > 0)?r:0, t);
+    return r;
+}
+
+void pw_instr_enter(const char *file, const char *func, int line) {
+    if(ctx_depth++ > 0) return;
+    ctx_file = file;
+    ctx_func = func;
+    ctx_line = line;
+}
+
+int pw_instr_leave(int r) {
+    if(ctx_depth > 0) ctx_depth--;
+    return r;
+}
+
+void pw_instr_reset() {
+    n_sites = 0;
+    dropped = 0;
+}
+
+size_t pw_instr_get_sites(const pw_instr_site_t **out) {
+    if(out) *out = sites;
+    return n_sites;
+}
+
+void pw_instr_dump() {
+    uint64_t total_bytes[N_PW_INSTR_KINDS] = {0};
+    uint64_t total_us[N_PW_INSTR_KINDS] = {0};
+
+    printf("%-17s %-28s %5s %8s %10s %10s\n", "kind", "site", "line", "calls", "bytes", "time_us");
+    for(size_t i = 0; i < n_sites; i++) {
+        pw_instr_site_t *s = &sites[i];
+        printf("%-17s %-28s %5u %8u %10llu %10llu\n",
+               PW_INSTR_KIND_NAMES[s->kind], s->func, s->line, s->calls,
+               (unsigned long long)s->bytes, (unsigned long long)s->time_us);
+        total_bytes[s->kind] += s->bytes;
+        total_us[s->kind] += s->time_us;
+    }
+
+    for(size_t k = 0; k < N_PW_INSTR_KINDS; k++) {
+        if(total_bytes[k] == 0 && total_us[k] == 0) continue;
+        printf("total %-17s %10llu bytes %10llu us\n", PW_INSTR_KIND_NAMES[k],
+               (unsigned long long)total_bytes[k], (unsigned long long)total_us[k]);
+    }
+
+    if(dropped) printf("%u calls not counted, site table full\n", dropped);
+}
+
+#else /* PW_INSTRUMENT */
+
+void pw_instr_enter(const char *file, const char *func, int line) {
+    (void)file;
+    (void)func;
+    (void)line;
+}
+
+int pw_instr_leave(int r) {
+    return r;
+}
+
+void pw_instr_reset() {
+}
+
+size_t pw_instr_get_sites(const pw_instr_site_t **out) {
+    if(out) *out = 0;
+    return 0;
+}
+
+void pw_instr_dump() {
+}
+
+#endif /* PW_INSTRUMENT */
@@ -0,0 +1,63 @@
+#ifndef PW_INSTRUMENT_H
+#define PW_INSTRUMENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// @file instrument.h
+
+/*
+ *  Optional driver-call instrumentation.
+ *
+ *  When the core is built with PW_INSTRUMENT defined, calls to the
+ *  eeprom, screen and IR driver functions made from core code are
+ *  routed through counting wrappers (see the bottom of eeprom.h,
+ *  screen.h and ir/ir.h). Each distinct call site gets its own
+ *  counters for calls, bytes moved and time spent in the driver.
+ *
+ *  Without PW_INSTRUMENT the wrappers don't exist and the driver is
+ *  called directly. The query functions below still link, but never
+ *  report any sites.
+ */
+
+#define PW_INSTR_MAX_SITES  96
+
+typedef enum {
+    PW_INSTR_EEPROM_READ,
+    PW_INSTR_EEPROM_WRITE,
+    PW_INSTR_EEPROM_SET,
+    PW_INSTR_SCREEN_DRAW,
+    PW_INSTR_SCREEN_CLEAR,
+    PW_INSTR_SCREEN_BLIT,
+    PW_INSTR_IR_READ,
+    PW_INSTR_IR_WRITE,
+    N_PW_INSTR_KINDS,
+} pw_instr_kind_t;
+
+typedef struct {
+    const char *file;
+    const char *func;
+    uint16_t line;
+    uint8_t  kind;      // pw_instr_kind_t
+    uint32_t calls;
+    uint64_t bytes;
+    uint64_t time_us;
+} pw_instr_site_t;
+
+#define PW_INSTR_HERE   __FILE__, __func__, __LINE__
+
+extern const char* const PW_INSTR_KIND_NAMES[];
+
+/*
+ *  Attribute driver calls made between enter and leave to the site
+ *  passed to enter, e.g. the caller of a cache function. Nests; the
+ *  outermost site wins. `leave` returns `r` so it can wrap an expression.
+ */
+void pw_instr_enter(const char *file, const char *func, int line);
+int pw_instr_leave(int r);
+
+void pw_instr_reset();
+size_t pw_instr_get_sites(const pw_instr_site_t **sites);
+void pw_instr_dump();
+
+#endif /* PW_INSTRUMENT_H */
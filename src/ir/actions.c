@@ -5,18 +5,46 @@
 
 #include "../eeprom_map.h"
 #include "../eeprom.h"
+#include "../eeprom_cache.h"
+#include "../eeprom_erase.h"
+#include "../eeprom_async.h"
+#include "../walk_copy.h"
+#include "../health_journal.h"
+#include "../utils.h"
+#include "../screen.h"
 #include "../types.h"
 #include "../states.h"
 #include "../rand.h"
 #include "ir.h"
 #include "actions.h"
 #include "compression.h"
+#include "transfer.h"
 #include "../globals.h"
 #include "../states.h"
 
 #define ACTION_DELAY_MS 1
 
+/*
+ *  Eeprom writes from the peer are queued and acked straight away, the
+ *  write itself happens while the next packet comes in. Reads of the
+ *  same range wait for it in the cache, see `pw_eeprom_async_fence()`.
+ */
+#ifndef PW_IR_WRITE_BEHIND_SLOTS
+#define PW_IR_WRITE_BEHIND_SLOTS    4
+#endif
+
+typedef struct {
+    pw_eeprom_req_t req;
+    uint8_t data[128];
+} write_behind_slot_t;
+
+static write_behind_slot_t write_behind[PW_IR_WRITE_BEHIND_SLOTS];
+static size_t write_behind_next = 0;
+
+static void pw_ir_write_behind_flush();
+
 ir_err_t pw_ir_eeprom_do_write(pw_packet_t *packet, size_t len);
+static void pw_ir_eeprom_written(eeprom_addr_t addr, size_t len);
 ir_err_t pw_ir_identity_ack(pw_packet_t *packet);
 
 /*
@@ -27,7 +55,8 @@ ir_err_t pw_action_listen_and_advertise(pw_packet_t *rx, size_t *pn_read, uint8_
 
     ir_err_t err = IR_ERR_TIMEOUT;
 
-    err = pw_ir_recv_packet(rx, 8, pn_read);
+    err = pw_ir_poll_packet(rx, 8, pn_read);
+    if(err == IR_ERR_AWAITING) return err;
 
     // if we didn't read anything, send an advertising packet
     if(*pn_read == 0) {
@@ -112,7 +141,7 @@ ir_err_t pw_action_try_find_peer(app_comms_t *comms, pw_packet_t *packet, size_t
     case COMM_SUBSTATE_AWAITING_SLAVE_ACK: {   // we have sent master request
 
         // wait for answer
-        err = pw_ir_recv_packet(packet, 8, &n_read);
+        err = pw_ir_poll_packet(packet, 8, &n_read);
         if(err != IR_OK) return err;
 
         if(packet->cmd != CMD_SLAVE_ACK) return IR_ERR_UNEXPECTED_PACKET;
@@ -145,6 +174,15 @@ ir_err_t pw_action_slave_perform_request(pw_packet_t *packet, size_t len) {
         packet->cmd = CMD_IDENTITY_RSP;
         packet->extra = EXTRA_BYTE_FROM_WALKER;
 
+        // the game reads watts straight from the eeprom, health data was
+        // committed when the comms app started
+        uint16_t be_watts = swap_bytes_u16(health_data_cache.current_watts), cur;
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_0xce8a, (uint8_t*)&cur, PW_EEPROM_SIZE_0xce8a);
+        if(cur != be_watts) {
+            pw_eeprom_cache_write(PW_EEPROM_ADDR_0xce8a, (uint8_t*)&be_watts, PW_EEPROM_SIZE_0xce8a);
+        }
+
+        // copy 1 is pinned in the cache, this doesn't touch the eeprom
         int r = pw_eeprom_reliable_read(
                     PW_EEPROM_ADDR_IDENTITY_DATA_1,
                     PW_EEPROM_ADDR_IDENTITY_DATA_2,
@@ -187,7 +225,7 @@ ir_err_t pw_action_slave_perform_request(pw_packet_t *packet, size_t len) {
 
         packet->cmd = CMD_EEPROM_READ_RSP;
         packet->extra = EXTRA_BYTE_FROM_WALKER;
-        pw_eeprom_read(addr, packet->payload, len);
+        pw_eeprom_cache_read(addr, packet->payload, len);
 
         pw_ir_delay_ms(ACTION_DELAY_MS);
 
@@ -217,6 +255,7 @@ ir_err_t pw_action_slave_perform_request(pw_packet_t *packet, size_t len) {
         pw_ir_delay_ms(ACTION_DELAY_MS);
         err = pw_ir_send_packet(packet, 8, &n_rw);
 
+        pw_ir_write_behind_flush();
         pw_ir_end_walk();
 
         pw_ir_set_comm_state(COMM_STATE_DISCONNECTED);
@@ -228,15 +267,18 @@ ir_err_t pw_action_slave_perform_request(pw_packet_t *packet, size_t len) {
         packet->extra = EXTRA_BYTE_FROM_WALKER;
         pw_ir_delay_ms(ACTION_DELAY_MS);
         err = pw_ir_send_packet(packet, 8, &n_rw);
+        pw_ir_write_behind_flush();
         pw_ir_start_walk();
         break;
     }
     case CMD_DISCONNECT: {
+        pw_ir_write_behind_flush();
         err = IR_OK;
         pw_ir_set_comm_state(COMM_STATE_DISCONNECTED);
         break;
     }
     case CMD_NOCOMPLETE_ALIAS1: {
+        pw_ir_write_behind_flush();
         err = IR_OK;
         pw_ir_set_comm_state(COMM_STATE_DISCONNECTED);
         break;
@@ -281,6 +323,36 @@ ir_err_t pw_action_slave_perform_request(pw_packet_t *packet, size_t len) {
  *  display animation
  *  calculate gift
  */
+/*
+ *  Run one step of a peer play transfer substate, moving on to `next`
+ *  once the whole section has gone across.
+ */
+static pw_transfer_t peer_play_transfer = {.state = PW_TRANSFER_IDLE};
+
+static ir_err_t pw_action_transfer_step(app_comms_t *comms, pw_packet_t *packet, pw_transfer_dir_t dir,
+                                        uint16_t src, uint16_t dst, uint16_t size, uint8_t next) {
+    pw_transfer_t *t = &peer_play_transfer;
+
+    if(t->state == PW_TRANSFER_IDLE)
+        pw_transfer_begin(t, dir, src, dst, size);
+
+    ir_err_t err = pw_transfer_run(t, packet, PW_TRANSFER_BUDGET_US);
+    if(err == IR_ERR_AWAITING) return err;
+    if(err != IR_OK) {
+        // we are about to disconnect, start over next time
+        t->state = PW_TRANSFER_IDLE;
+        return err;
+    }
+
+    if(pw_transfer_done(t)) {
+        t->state = PW_TRANSFER_IDLE;
+        comms->advertising_attempts = 0;
+        comms->current_substate = next;
+    }
+
+    return IR_OK;
+}
+
 ir_err_t pw_action_peer_play(app_comms_t *comms, pw_packet_t *packet, size_t max_len) {
     ir_err_t err = IR_ERR_UNHANDLED_ERROR;
     size_t n_read;
@@ -292,7 +364,7 @@ ir_err_t pw_action_peer_play(app_comms_t *comms, pw_packet_t *packet, size_t max
         packet->extra = EXTRA_BYTE_FROM_WALKER;
         pw_eeprom_reliable_read(PW_EEPROM_ADDR_IDENTITY_DATA_1, PW_EEPROM_ADDR_IDENTITY_DATA_2,
                                 packet->payload, PW_EEPROM_SIZE_IDENTITY_DATA_1);
-        //pw_eeprom_read(PW_EEPROM_ADDR_IDENTITY_DATA_1,
+        //pw_eeprom_cache_read(PW_EEPROM_ADDR_IDENTITY_DATA_1,
         //        packet+8, PW_EEPROM_SIZE_IDENTITY_DATA_1);
         packet->bytes[0x18] = (uint8_t)(pw_rand()&0xff);  // Hack to change UID each time
         // to prevent "already connected" error
@@ -305,7 +377,8 @@ ir_err_t pw_action_peer_play(app_comms_t *comms, pw_packet_t *packet, size_t max
     }
     case COMM_SUBSTATE_PEER_PLAY_ACK: {
 
-        err = pw_ir_recv_packet(packet, 8+PW_EEPROM_SIZE_IDENTITY_DATA_1, &n_read);
+        err = pw_ir_poll_packet(packet, 8+PW_EEPROM_SIZE_IDENTITY_DATA_1, &n_read);
+        if(err == IR_ERR_AWAITING) return err;
         switch(packet->cmd) {
         case CMD_PEER_PLAY_RSP:
             break;
@@ -321,113 +394,57 @@ ir_err_t pw_action_peer_play(app_comms_t *comms, pw_packet_t *packet, size_t max
         break;
     }
     case COMM_SUBSTATE_SEND_MASTER_SPRITES: {
-
-        size_t write_size = 128;    // should always be 128-bytes
-        size_t cur_write_size   = (size_t)(comms->advertising_attempts) * write_size;
-
-        err = pw_action_send_large_raw_data_from_eeprom(
-                  PW_EEPROM_ADDR_IMG_POKEMON_SMALL_ANIMATED,              // src
-                  PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL, // dst
-                  PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED,              // size
-                  write_size, &(comms->advertising_attempts), packet, max_len
-              );
-        if(err != IR_OK) return err;
-
-        if(cur_write_size >= PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED) {
-            comms->advertising_attempts = 0;  // reset loop counter
-            comms->current_substate = COMM_SUBSTATE_SEND_MASTER_NAME_IMAGE;
-        }
+        err = pw_action_transfer_step(comms, packet, PW_TRANSFER_SEND,
+                                      PW_EEPROM_ADDR_IMG_POKEMON_SMALL_ANIMATED,              // src
+                                      PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL, // dst
+                                      PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED,              // size
+                                      COMM_SUBSTATE_SEND_MASTER_NAME_IMAGE
+                                     );
         break;
     }
     case COMM_SUBSTATE_SEND_MASTER_NAME_IMAGE: {
-
-        size_t write_size = 128;
-        size_t cur_write_size   = (size_t)(comms->advertising_attempts) * write_size;
-
-        err = pw_action_send_large_raw_data_from_eeprom(
-                  PW_EEPROM_ADDR_TEXT_POKEMON_NAME,               // src
-                  PW_EEPROM_ADDR_TEXT_CURRENT_PEER_POKEMON_NAME,  // dst
-                  PW_EEPROM_SIZE_TEXT_POKEMON_NAME,               // size
-                  write_size, &(comms->advertising_attempts), packet, max_len
-              );
-
-        if(cur_write_size >= PW_EEPROM_SIZE_TEXT_POKEMON_NAME) {
-            comms->advertising_attempts = 0; // reset loop counter
-            comms->current_substate = COMM_SUBSTATE_SEND_MASTER_TEAMDATA;
-        }
+        err = pw_action_transfer_step(comms, packet, PW_TRANSFER_SEND,
+                                      PW_EEPROM_ADDR_TEXT_POKEMON_NAME,               // src
+                                      PW_EEPROM_ADDR_TEXT_CURRENT_PEER_POKEMON_NAME,  // dst
+                                      PW_EEPROM_SIZE_TEXT_POKEMON_NAME,               // size
+                                      COMM_SUBSTATE_SEND_MASTER_TEAMDATA
+                                     );
         break;
     }
     case COMM_SUBSTATE_SEND_MASTER_TEAMDATA: {
-
-        size_t write_size = 128;
-        size_t cur_write_size   = (size_t)(comms->advertising_attempts) * write_size;
-
-        err = pw_action_send_large_raw_data_from_eeprom(
-                  PW_EEPROM_ADDR_TEAM_DATA_STRUCT,            // src
-                  PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA,      // dst
-                  PW_EEPROM_SIZE_TEAM_DATA_STRUCT,            // size
-                  write_size, &(comms->advertising_attempts), packet, max_len
-              );
-
-        if(cur_write_size >= PW_EEPROM_SIZE_TEAM_DATA_STRUCT) {
-            comms->advertising_attempts = 0; // reset loop counter
-            comms->current_substate = COMM_SUBSTATE_READ_SLAVE_SPRITES;
-        }
+        err = pw_action_transfer_step(comms, packet, PW_TRANSFER_SEND,
+                                      PW_EEPROM_ADDR_TEAM_DATA_STRUCT,            // src
+                                      PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA,      // dst
+                                      PW_EEPROM_SIZE_TEAM_DATA_STRUCT,            // size
+                                      COMM_SUBSTATE_READ_SLAVE_SPRITES
+                                     );
         break;
     }
     case COMM_SUBSTATE_READ_SLAVE_SPRITES: {
-
-        size_t read_size = 128; // NOTE: this can be anything so long as it fits in your buffer
-        // TODO: move this buffer dependancy inti pw_ir_read()
-        err = pw_action_read_large_raw_data_from_eeprom(
-                  PW_EEPROM_ADDR_IMG_POKEMON_SMALL_ANIMATED,              // src
-                  PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL, // dst
-                  PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED,              // size
-                  read_size, &(comms->advertising_attempts), packet, max_len
-              );
-
-        size_t cur_read_size   = (size_t)(comms->advertising_attempts) * read_size;
-
-        if(cur_read_size >= PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED) {
-            comms->advertising_attempts = 0;  // reset loop counter
-            comms->current_substate = COMM_SUBSTATE_READ_SLAVE_NAME_IMAGE;
-        }
+        err = pw_action_transfer_step(comms, packet, PW_TRANSFER_READ,
+                                      PW_EEPROM_ADDR_IMG_POKEMON_SMALL_ANIMATED,              // src
+                                      PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL, // dst
+                                      PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED,              // size
+                                      COMM_SUBSTATE_READ_SLAVE_NAME_IMAGE
+                                     );
         break;
     }
     case COMM_SUBSTATE_READ_SLAVE_NAME_IMAGE: {
-
-        size_t read_size = 128;  // TODO: See above
-        err = pw_action_read_large_raw_data_from_eeprom(
-                  PW_EEPROM_ADDR_TEXT_POKEMON_NAME,               // src
-                  PW_EEPROM_ADDR_TEXT_CURRENT_PEER_POKEMON_NAME,  // dst
-                  PW_EEPROM_SIZE_TEXT_POKEMON_NAME,               // size
-                  read_size, &(comms->advertising_attempts), packet, max_len
-              );
-
-        size_t cur_read_size   = (size_t)(comms->advertising_attempts) * read_size;
-
-        if(cur_read_size >= PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED) {
-            comms->advertising_attempts = 0;  // reset loop counter
-            comms->current_substate = COMM_SUBSTATE_READ_SLAVE_TEAMDATA;
-        }
+        err = pw_action_transfer_step(comms, packet, PW_TRANSFER_READ,
+                                      PW_EEPROM_ADDR_TEXT_POKEMON_NAME,               // src
+                                      PW_EEPROM_ADDR_TEXT_CURRENT_PEER_POKEMON_NAME,  // dst
+                                      PW_EEPROM_SIZE_TEXT_POKEMON_NAME,               // size
+                                      COMM_SUBSTATE_READ_SLAVE_TEAMDATA
+                                     );
         break;
     }
     case COMM_SUBSTATE_READ_SLAVE_TEAMDATA: {
-
-        size_t read_size = 128;  // TODO: See above
-        err = pw_action_read_large_raw_data_from_eeprom(
-                  PW_EEPROM_ADDR_IMG_POKEMON_SMALL_ANIMATED,              // src
-                  PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL, // dst
-                  PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED,              // size
-                  read_size, &(comms->advertising_attempts), packet, max_len
-              );
-
-        size_t cur_read_size   = (size_t)(comms->advertising_attempts) * read_size;
-
-        if(cur_read_size >= PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED) {
-            comms->advertising_attempts = 0;  // reset loop counter
-            comms->current_substate = COMM_SUBSTATE_SEND_PEER_PLAY_DX;
-        }
+        err = pw_action_transfer_step(comms, packet, PW_TRANSFER_READ,
+                                      PW_EEPROM_ADDR_TEAM_DATA_STRUCT,            // src
+                                      PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA,      // dst
+                                      PW_EEPROM_SIZE_TEAM_DATA_STRUCT,            // size
+                                      COMM_SUBSTATE_SEND_PEER_PLAY_DX
+                                     );
         break;
     }
     case COMM_SUBSTATE_SEND_PEER_PLAY_DX: {
@@ -450,15 +467,15 @@ ir_err_t pw_action_peer_play(app_comms_t *comms, pw_packet_t *packet, size_t max
         packet->payload[0x0c] = 7;   // identity_data_t.unk2
         packet->payload[0x0d] = 0;
         // species
-        pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_INFO+0, packet->bytes+0x16, 2);
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_ROUTE_INFO+0, packet->bytes+0x16, 2);
         // 22 bytes pokemon nickname
-        pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_INFO+10, packet->bytes+0x18, 22);
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_ROUTE_INFO+10, packet->bytes+0x18, 22);
         // 16 bytes trainer name
-        pw_eeprom_read(PW_EEPROM_ADDR_IDENTITY_DATA_1+72, packet->bytes+0x2e, 16);
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_IDENTITY_DATA_1+72, packet->bytes+0x2e, 16);
         // 1 byte pokemon gender
-        pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_INFO+13, packet->bytes+0x3e, 1);
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_ROUTE_INFO+13, packet->bytes+0x3e, 1);
         // 1 byte pokeIsSpecial
-        pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_INFO+14, packet->bytes+0x3f, 1);
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_ROUTE_INFO+14, packet->bytes+0x3f, 1);
 
         // TODO: move sizze to #define
         err = pw_ir_send_packet(packet, 0x40, &n_read);;
@@ -468,10 +485,10 @@ ir_err_t pw_action_peer_play(app_comms_t *comms, pw_packet_t *packet, size_t max
         break;
     }
     case COMM_SUBSTATE_RECV_PEER_PLAY_DX: {
-        err = pw_ir_recv_packet(packet, 0x40, &n_read);
+        err = pw_ir_poll_packet(packet, 0x40, &n_read);
         if(err != IR_OK) return err;
 
-        pw_eeprom_write(PW_EEPROM_ADDR_CURRENT_PEER_DATA, packet->payload, PW_EEPROM_SIZE_CURRENT_PEER_DATA);
+        pw_eeprom_cache_write(PW_EEPROM_ADDR_CURRENT_PEER_DATA, packet->payload, PW_EEPROM_SIZE_CURRENT_PEER_DATA);
 
         comms->current_substate = COMM_SUBSTATE_SEND_PEER_PLAY_END;
         break;
@@ -485,7 +502,7 @@ ir_err_t pw_action_peer_play(app_comms_t *comms, pw_packet_t *packet, size_t max
         break;
     }
     case COMM_SUBSTATE_RECV_PEER_PLAY_END: {
-        err = pw_ir_recv_packet(packet, 8, &n_read);
+        err = pw_ir_poll_packet(packet, 8, &n_read);
         if(err != IR_OK) return err;
         if(packet->cmd != CMD_PEER_PLAY_END) return IR_ERR_UNEXPECTED_PACKET;
         comms->current_substate = COMM_SUBSTATE_DISPLAY_PEER_PLAY_ANIMATION;
@@ -536,11 +553,14 @@ ir_err_t pw_action_send_large_raw_data_from_eeprom(uint16_t src, uint16_t dst, s
     pw_ir_delay_ms(ACTION_DELAY_MS);
 
     if( cur_write_size < final_write_size) {
-        packet->cmd = (uint8_t)(cur_write_addr&0xff) + 2; // Need +2 to make it raw write command
+        uint8_t raw[PW_COMPRESS_MAX_INPUT];
+        if(write_size > sizeof(raw)) return IR_ERR_LONG_PACKET;
+
+        pw_eeprom_cache_read(cur_read_addr, raw, write_size);
         packet->extra = (uint8_t)(cur_write_addr>>8);
-        pw_eeprom_read(cur_read_addr, packet->payload, write_size);
+        size_t payload_len = pw_transfer_encode_write(cur_write_addr, raw, write_size, &packet->cmd, packet->payload);
 
-        err = pw_ir_send_packet(packet, 8+write_size, &n_read);
+        err = pw_ir_send_packet(packet, 8+payload_len, &n_read);
         if(err != IR_OK) return err;
         (*pcounter)++;
     }
@@ -583,7 +603,7 @@ ir_err_t pw_action_read_large_raw_data_from_eeprom(uint16_t src, uint16_t dst, s
     if(err != IR_OK) return err;
     if(packet->cmd != CMD_EEPROM_READ_RSP) return IR_ERR_UNEXPECTED_PACKET;
 
-    pw_eeprom_write(cur_write_addr, packet->payload, read_size);
+    pw_eeprom_cache_write(cur_write_addr, packet->payload, read_size);
 
     (*pcounter)++;
 
@@ -618,12 +638,10 @@ ir_err_t pw_action_send_large_raw_data_from_pointer(uint8_t *src, uint16_t dst,
     pw_ir_delay_ms(ACTION_DELAY_MS);
 
     if( cur_write_size < final_write_size) {
-        packet->cmd = (uint8_t)(cur_write_addr&0xff) + 2; // Need +2 to make it raw write command
         packet->extra = (uint8_t)(cur_write_addr>>8);
-        //pw_eeprom_read(cur_read_addr, packet+8, write_size);
-        memcpy(packet->payload, cur_read_addr, write_size);
+        size_t payload_len = pw_transfer_encode_write(cur_write_addr, cur_read_addr, write_size, &packet->cmd, packet->payload);
 
-        err = pw_ir_send_packet(packet, 8+write_size, &n_read);
+        err = pw_ir_send_packet(packet, 8+payload_len, &n_read);
         if(err != IR_OK) return err;
         (*pcounter)++;
     }
@@ -631,13 +649,45 @@ ir_err_t pw_action_send_large_raw_data_from_pointer(uint8_t *src, uint16_t dst,
     return err;
 }
 
+/*
+ *  Queue one piece of a peer write, at most a slot's worth.
+ */
+static void pw_ir_write_behind(eeprom_addr_t addr, const uint8_t *data, size_t len) {
+    // slots are used in turn, so the next one is the oldest
+    write_behind_slot_t *slot = &write_behind[write_behind_next];
+    write_behind_next = (write_behind_next+1)%PW_IR_WRITE_BEHIND_SLOTS;
+
+    pw_eeprom_async_wait(&slot->req);
+    memcpy(slot->data, data, len);
+    if(!pw_eeprom_async_write(&slot->req, addr, slot->data, len, 0, 0)) {
+        pw_eeprom_cache_write(addr, slot->data, len);  // queue full
+    }
+}
+
+/*
+ *  Decompressed pieces go straight into write-behind slots.
+ */
+typedef struct {
+    eeprom_addr_t addr;
+    size_t queued;
+} write_behind_stream_t;
+
+static int pw_ir_write_behind_sink(const uint8_t *piece, size_t len, size_t offset, void *ctx) {
+    write_behind_stream_t *ws = (write_behind_stream_t*)ctx;
+
+    if(len > sizeof(write_behind[0].data)) return -1;
+    if((uint32_t)ws->addr + offset + len > 0x10000) return -1;
+
+    pw_ir_write_behind(ws->addr+offset, piece, len);
+    ws->queued = offset+len;
+    return 0;
+}
+
 ir_err_t pw_ir_eeprom_do_write(pw_packet_t *packet, size_t len) {
-    ir_err_t err = IR_OK;
-    uint8_t *data;
-    uint8_t wlen = 128;
+    size_t wlen = 128;
 
     uint8_t cmd = packet->cmd;
-    uint16_t addr = (packet->extra<<8) | (cmd&0x80);
+    eeprom_addr_t addr = (packet->extra<<8) | (cmd&0x80);
     // compressed if 0x00 or 0x02 and length < 136
     bool cmp = ( (cmd&0x02) == 0 ) && (len<0x88);
 
@@ -645,22 +695,45 @@ ir_err_t pw_ir_eeprom_do_write(pw_packet_t *packet, size_t len) {
 
     //printf("addr: %04x", addr);
     if(cmp) {
-        // decompress
-        int e = pw_decompress_data(packet->payload, decompression_buf, len-8);
-        if(e != 0) return IR_ERR_BAD_DATA;
-        data = decompression_buf;
+        // decompress, any size, a page at a time
+        write_behind_stream_t ws = {addr, 0};
+        int n = pw_decompress_stream(packet->payload, len-8, pw_ir_write_behind_sink, &ws);
+        if(n < 0) {
+            // bad data part way through, what did get written still counts
+            if(ws.queued > 0) pw_ir_eeprom_written(addr, ws.queued);
+            return IR_ERR_BAD_DATA;
+        }
+        wlen = n;
     } else {
-        data = packet->payload;
+        pw_ir_write_behind(addr, packet->payload, wlen);
     }
 
-    if(addr == 0xd700) {
-        printf("decomp species: %02x%02x\n", data[1], data[0]);
-    }
+    pw_ir_eeprom_written(addr, wlen);
 
-    //printf("\n");
-    pw_eeprom_write(addr, data, wlen);
+    return IR_OK;
+}
 
-    return err;
+/*
+ *  Wait for every queued peer write to land.
+ */
+static void pw_ir_write_behind_flush() {
+    for(size_t i = 0; i < PW_IR_WRITE_BEHIND_SLOTS; i++)
+        pw_eeprom_async_wait(&write_behind[i].req);
+}
+
+/*
+ *  The peer has just written [addr, addr+len), drop any RAM copies of it.
+ */
+static void pw_ir_eeprom_written(eeprom_addr_t addr, size_t len) {
+    uint32_t end = (uint32_t)addr + len;
+
+    pw_eeprom_reliable_invalidate(addr, len);
+    pw_inventory_invalidate(addr, len);
+    pw_route_index_invalidate(addr, len);
+
+    if(addr < PW_EEPROM_ADDR_IMG_DIGITS+PW_EEPROM_SIZE_IMG_DIGITS && end > PW_EEPROM_ADDR_IMG_DIGITS) {
+        pw_screen_invalidate_glyphs();
+    }
 }
 
 
@@ -687,75 +760,44 @@ void pw_ir_end_walk() {
     );
 
 
-    pw_eeprom_set_area(PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY, 0, 0x64);
-    pw_eeprom_set_area(PW_EEPROM_ADDR_EVENT_LOG, 0, PW_EEPROM_SIZE_EVENT_LOG);
-    pw_eeprom_set_area(PW_EEPROM_ADDR_RECEIVED_BITFIELD, 0, 0x6c8);
-    pw_eeprom_set_area(PW_EEPROM_ADDR_MET_PEER_DATA, 0, 0x1568);
-    pw_eeprom_set_area(PW_EEPROM_ADDR_ROUTE_INFO, 0, 0x10);
+    pw_eeprom_erase_lazy(PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY, 0x64);
+    pw_eeprom_erase_lazy(PW_EEPROM_ADDR_EVENT_LOG, PW_EEPROM_SIZE_EVENT_LOG);
+    pw_eeprom_erase_lazy(PW_EEPROM_ADDR_RECEIVED_BITFIELD, 0x6c8);
+    pw_eeprom_erase_lazy(PW_EEPROM_ADDR_MET_PEER_DATA, 0x1568);
+    pw_eeprom_cache_set_area(PW_EEPROM_ADDR_ROUTE_INFO, 0, 0x10);
+    pw_inventory_invalidate_all();
+    pw_route_index_invalidate(PW_EEPROM_ADDR_ROUTE_INFO, 0x10);
 
+    pw_eeprom_cache_flush();
 }
 
 
 void pw_ir_start_walk() {
 
     uint8_t *buf = eeprom_buf;
-    size_t buf_size = EEPROM_BUF_SIZE;
-    int n = 0;
-
-    buf[0] = 0xa5;
-    n = pw_eeprom_reliable_write(
-            PW_EEPROM_ADDR_COPY_MARKER_1,
-            PW_EEPROM_ADDR_COPY_MARKER_2,
-            buf,
-            1
-        );
-
-    // buf_size must wholly divide into copy size
-    const size_t sz = 128;
-    for(size_t i = 0; i < 0x2900; i+=sz) {
-        // Sometimes reads zero here for x amount of bytes
-        // but later on line 746, it reads ok
-        int a = pw_eeprom_read(PW_EEPROM_ADDR_SCENARIO_STAGING_AREA+i, buf, sz);
-        uint16_t species = buf[0] | (uint16_t)(buf[1])<<8;
-        if(i == 0 && species == 0) {
-            printf("n read: %d\n", a);
-        }
-        pw_eeprom_write(PW_EEPROM_ADDR_ROUTE_INFO+i, buf, sz);
-    }
 
-    for(size_t i = 0; i < 0x280; i+=sz) {
-        pw_eeprom_read(PW_EEPROM_ADDR_TEAM_DATA_STAGING+i, buf, sz);
-        pw_eeprom_read(PW_EEPROM_ADDR_TEAM_DATA_STRUCT+i,  buf, sz);
-    }
-
-    buf[0] = 0x00;
-    n = pw_eeprom_reliable_write(
-            PW_EEPROM_ADDR_COPY_MARKER_1,
-            PW_EEPROM_ADDR_COPY_MARKER_2,
-            buf,
-            1
-        );
+    /*
+     *  Team data is copied out of staging and the staged route made live
+     *  in the background, the comms app waits for it before leaving.
+     */
+    pw_walk_copy_begin();
 
     health_data_cache.walk_minute_counter = 0;
     health_data_cache.event_log_index = 0;
     health_data_cache.current_watts = 0;
 
-    n = pw_eeprom_reliable_write(
-            PW_EEPROM_ADDR_HEALTH_DATA_1,
-            PW_EEPROM_ADDR_HEALTH_DATA_2,
-            (uint8_t*)&health_data_cache,
-            sizeof(health_data_cache)
-        );
+    pw_health_commit();
 
     // this always reads ok, so the write must have been fine
     route_info_t *route_info = (route_info_t*)buf;
-    pw_eeprom_read(PW_EEPROM_ADDR_SCENARIO_STAGING_AREA, (uint8_t*)route_info, PW_EEPROM_SIZE_ROUTE_INFO);
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_SCENARIO_STAGING_AREA, (uint8_t*)route_info, PW_EEPROM_SIZE_ROUTE_INFO);
     printf("d700 species: %04x\n", route_info->pokemon_summary.le_species);
 
 
-    pw_eeprom_set_area(PW_EEPROM_ADDR_EVENT_LOG, 0, PW_EEPROM_SIZE_EVENT_LOG);
-    pw_eeprom_set_area(PW_EEPROM_ADDR_MET_PEER_DATA, 0, 0x1568);
-    pw_eeprom_set_area(PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY, 0, 0x64);
+    // the met peers are wiped by the walk copy, just before the bank flips
+    pw_eeprom_erase_lazy(PW_EEPROM_ADDR_EVENT_LOG, PW_EEPROM_SIZE_EVENT_LOG);
+    pw_eeprom_erase_lazy(PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY, 0x64);
+    pw_inventory_invalidate_all();
 
     //walker_info_t *info = (walker_info_t*)buf;
     walker_info_t *info = &walker_info_cache;
@@ -803,10 +845,9 @@ void pw_ir_start_walk() {
 
     event_log_item_t *event_item = malloc(sizeof(*event_item));
 
-    pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_INFO, (uint8_t*)route_info, PW_EEPROM_SIZE_ROUTE_INFO);
-    printf("8f00 species: %04x\n", route_info->pokemon_summary.le_species);
-    //pw_eeprom_read(0xd700, (uint8_t*)route_info, PW_EEPROM_SIZE_ROUTE_INFO);
-    //printf("d700 species: %04x\n", route_info->pokemon_summary.le_species);
+    // the route bank only flips once walker_loop() has run the copy
+    // above, until then the new route is still at staging
+    pw_eeprom_cache_read(PW_EEPROM_ADDR_SCENARIO_STAGING_AREA, (uint8_t*)route_info, PW_EEPROM_SIZE_ROUTE_INFO);
 
 
     event_item->le_our_species = route_info->pokemon_summary.le_species;
@@ -824,10 +865,12 @@ void pw_ir_start_walk() {
     pw_log_event(event_item);
 
     free(event_item);
+
+    pw_eeprom_cache_flush();
 }
 
 void pw_log_event(event_log_item_t *event_item) {
-    pw_eeprom_write(PW_EEPROM_ADDR_EVENT_LOG, (uint8_t*)event_item, sizeof(*event_item));
+    pw_eeprom_cache_write(PW_EEPROM_ADDR_EVENT_LOG, (uint8_t*)event_item, sizeof(*event_item));
 }
 
 
@@ -1,64 +1,291 @@
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
 
 #include "compression.h"
 
-void pw_compress_data(uint8_t *data, uint8_t *buf, size_t dlen) {
+/*
+ *  LZ encoder for the 0x10 format read by pw_decompress_data():
+ *      0x10, 24-bit LE decompressed size,
+ *      then groups of one flag byte (MSB first) and up to 8 tokens.
+ *  A set flag is a 2-byte back-reference:
+ *      ((len-3)<<4) | ((disp-1)>>8), (disp-1)&0xff
+ *  with len 3..18 and disp 1..4096, a clear flag is one literal byte.
+ *
+ *  `level` trades speed for size:
+ *      PW_COMPRESS_FAST    greedy, only looks PW_COMPRESS_FAST_WINDOW bytes back
+ *      PW_COMPRESS_NORMAL  greedy, whole window
+ *      PW_COMPRESS_BEST    cheapest parse of the whole input (dlen <= PW_COMPRESS_MAX_INPUT)
+ *
+ *  Returns the number of bytes written to `buf`, or 0 if the output
+ *  would not fit in `buf_len`, i.e. it is not worth sending compressed.
+ */
+
+#define LZ_MIN_MATCH    3
+#define LZ_MAX_MATCH    18
+#define LZ_MAX_DISP     4096
 
+typedef struct {
+    uint8_t *buf;
+    size_t buf_len;
+    size_t oc;          // output cursor
+    size_t flag_pos;    // where the current flag byte lives
+    uint8_t flag_bit;   // next flag bit, 0 when a new flag byte is needed
+} lz_writer_t;
+
+static bool lz_token(lz_writer_t *w, bool is_ref, size_t n_bytes) {
+    if(w->flag_bit == 0) {
+        if(w->oc >= w->buf_len) return false;
+        w->flag_pos = w->oc++;
+        w->buf[w->flag_pos] = 0;
+        w->flag_bit = 0x80;
+    }
+    if(w->oc + n_bytes > w->buf_len) return false;
+
+    if(is_ref) w->buf[w->flag_pos] |= w->flag_bit;
+    w->flag_bit >>= 1;
+    return true;
+}
+
+static bool lz_literal(lz_writer_t *w, uint8_t b) {
+    if(!lz_token(w, false, 1)) return false;
+    w->buf[w->oc++] = b;
+    return true;
+}
+
+static bool lz_backref(lz_writer_t *w, size_t len, size_t disp) {
+    if(!lz_token(w, true, 2)) return false;
+    w->buf[w->oc++] = ((len-LZ_MIN_MATCH)<<4) | ((disp-1)>>8);
+    w->buf[w->oc++] = (disp-1)&0xff;
+    return true;
 }
 
 /*
- *  data is packet minus 8-byte header
- *  Assume buf can hold decompressed data
+ *  Longest match for position `i` looking at most `window` bytes back.
+ *  Overlapping matches are fine, the decoder copies byte by byte.
  */
-int pw_decompress_data(uint8_t *data, uint8_t *buf, size_t dlen) {
-    if(data == 0 || buf == 0) return -1;
+static size_t lz_longest_match(const uint8_t *data, size_t dlen, size_t i, size_t window, size_t *pdisp) {
+    size_t best_len = 0;
+    size_t max_len = dlen - i;
+    if(max_len > LZ_MAX_MATCH) max_len = LZ_MAX_MATCH;
+    if(window > i) window = i;
+
+    for(size_t disp = 1; disp <= window; disp++) {
+        const uint8_t *a = &data[i], *b = &data[i-disp];
+        if(b[best_len] != a[best_len] || b[0] != a[0]) continue;
+
+        size_t len = 0;
+        while(len < max_len && a[len] == b[len]) len++;
+        if(len > best_len) {
+            best_len = len;
+            *pdisp = disp;
+            if(len == max_len) break;
+        }
+    }
+
+    return best_len;
+}
 
-    size_t c = 0;
-    size_t oc = 0;
+static size_t lz_compress_greedy(lz_writer_t *w, const uint8_t *data, size_t dlen, size_t window) {
+    size_t i = 0;
+    while(i < dlen) {
+        size_t disp = 0;
+        size_t len = lz_longest_match(data, dlen, i, window, &disp);
 
-    uint8_t decomp_type = data[c++];
-    if(decomp_type != 0x10)
-        return -1;
+        if(len >= LZ_MIN_MATCH) {
+            if(!lz_backref(w, len, disp)) return 0;
+            i += len;
+        } else {
+            if(!lz_literal(w, data[i])) return 0;
+            i++;
+        }
+    }
+    return w->oc;
+}
+
+/*
+ *  Cost in bits from each position to the end, counting the flag bit:
+ *  9 for a literal, 17 for a back-reference. Walk backwards picking the
+ *  cheapest choice at each position, then emit forwards.
+ */
+static size_t lz_compress_best(lz_writer_t *w, const uint8_t *data, size_t dlen) {
+    uint16_t cost[PW_COMPRESS_MAX_INPUT+1];
+    uint8_t  choice_len[PW_COMPRESS_MAX_INPUT];
+    uint16_t choice_disp[PW_COMPRESS_MAX_INPUT];
+
+    cost[dlen] = 0;
+    for(size_t i = dlen; i-- > 0;) {
+        cost[i] = 9 + cost[i+1];
+        choice_len[i] = 1;
+
+        size_t max_len = dlen - i;
+        if(max_len > LZ_MAX_MATCH) max_len = LZ_MAX_MATCH;
+        size_t window = (i < LZ_MAX_DISP)?i:LZ_MAX_DISP;
+
+        for(size_t disp = 1; disp <= window; disp++) {
+            size_t len = 0;
+            while(len < max_len && data[i+len] == data[i-disp+len]) len++;
+
+            // any prefix of a match is a match too
+            for(size_t l = LZ_MIN_MATCH; l <= len; l++) {
+                if(17 + cost[i+l] < cost[i]) {
+                    cost[i] = 17 + cost[i+l];
+                    choice_len[i] = l;
+                    choice_disp[i] = disp;
+                }
+            }
+        }
+    }
+
+    for(size_t i = 0; i < dlen;) {
+        if(choice_len[i] >= LZ_MIN_MATCH) {
+            if(!lz_backref(w, choice_len[i], choice_disp[i])) return 0;
+            i += choice_len[i];
+        } else {
+            if(!lz_literal(w, data[i])) return 0;
+            i++;
+        }
+    }
+    return w->oc;
+}
+
+size_t pw_compress_data(const uint8_t *data, uint8_t *buf, size_t dlen, size_t buf_len, uint8_t level) {
+    if(data == 0 || buf == 0) return 0;
+    if(buf_len < 4 || dlen > 0xffffff) return 0;
+
+    buf[0] = 0x10;
+    buf[1] = (uint8_t)(dlen);
+    buf[2] = (uint8_t)(dlen>>8);
+    buf[3] = (uint8_t)(dlen>>16);
+
+    lz_writer_t w = {
+        .buf = buf,
+        .buf_len = buf_len,
+        .oc = 4,
+        .flag_pos = 0,
+        .flag_bit = 0,
+    };
+
+    switch(level) {
+    case PW_COMPRESS_FAST:
+        return lz_compress_greedy(&w, data, dlen, PW_COMPRESS_FAST_WINDOW);
+    case PW_COMPRESS_NORMAL:
+        return lz_compress_greedy(&w, data, dlen, LZ_MAX_DISP);
+    case PW_COMPRESS_BEST:
+    default:
+        if(dlen > PW_COMPRESS_MAX_INPUT)
+            return lz_compress_greedy(&w, data, dlen, LZ_MAX_DISP);
+        return lz_compress_best(&w, data, dlen);
+    }
+}
+
+/*
+ *  Decoder side. Output goes through the last PW_DECOMPRESS_WINDOW bytes
+ *  in `window`, and is handed to the sink whenever a whole
+ *  PW_DECOMPRESS_PIECE has built up. Pieces start at multiples of the
+ *  piece size, which divides the window, so each one is contiguous.
+ */
+#if (PW_DECOMPRESS_WINDOW & (PW_DECOMPRESS_WINDOW-1)) || PW_DECOMPRESS_WINDOW > LZ_MAX_DISP
+#error "PW_DECOMPRESS_WINDOW must be a power of 2, at most 4096"
+#endif
+#if PW_DECOMPRESS_WINDOW % PW_DECOMPRESS_PIECE
+#error "PW_DECOMPRESS_PIECE must divide PW_DECOMPRESS_WINDOW"
+#endif
+
+#define WINDOW_AT(i)    window[(i)&(PW_DECOMPRESS_WINDOW-1)]
+
+static uint8_t window[PW_DECOMPRESS_WINDOW];
+
+typedef struct {
+    pw_decompress_sink_t sink;
+    void *ctx;
+    size_t oc;          // bytes decoded
+    size_t emitted;     // bytes given to the sink
+} lz_reader_t;
+
+static int lz_emit(lz_reader_t *r) {
+    size_t n = r->oc - r->emitted;
+    if(n == 0) return 0;
+
+    int e = r->sink(&WINDOW_AT(r->emitted), n, r->emitted, r->ctx);
+    r->emitted = r->oc;
+    return e;
+}
+
+static int lz_put(lz_reader_t *r, uint8_t b) {
+    WINDOW_AT(r->oc) = b;
+    r->oc++;
+    if(r->oc - r->emitted == PW_DECOMPRESS_PIECE) return lz_emit(r);
+    return 0;
+}
+
+/*
+ *  `data` is the packet minus its 8-byte header. Decodes any declared
+ *  size, checking every token against the input length, the declared
+ *  size and the window. Returns the decoded size, or -1 if the data is
+ *  bad or the sink returned non-zero. The sink may already have been
+ *  given some pieces when it fails.
+ */
+int pw_decompress_stream(const uint8_t *data, size_t dlen, pw_decompress_sink_t sink, void *ctx) {
+    if(data == 0 || sink == 0 || dlen < 4) return -1;
+    if(data[0] != 0x10) return -1;
 
     // LE size
-    uint32_t decomp_size = data[c] | data[c+1] << 8 | data[c+2] << 16;
-    if(decomp_size != 128)
-        return -1;
-    c += 3;
+    size_t size = data[1] | data[2] << 8 | (uint32_t)data[3] << 16;
+    size_t c = 4;
 
-    while(c < dlen) {
-        // loop through header
+    lz_reader_t r = {
+        .sink = sink,
+        .ctx = ctx,
+        .oc = 0,
+        .emitted = 0,
+    };
+
+    while(r.oc < size) {
+        if(c >= dlen) return -1;
         uint8_t header = data[c++];
-        for(uint8_t chunk_idx = (1<<7); chunk_idx > 0 && oc < decomp_size; chunk_idx >>= 1) {
-            uint8_t cmd = header & chunk_idx;
 
-            if(cmd != 0) {
+        for(uint8_t flag = (1<<7); flag > 0 && r.oc < size; flag >>= 1) {
+            if(header & flag) {
                 // 2-byte backreference
-                uint8_t sz = (data[c]>>4) + 3;
-                uint16_t backref = (( (data[c]&0x0f) << 8) | (data[c+1] )) + 1;
+                if(c+2 > dlen) return -1;
+                size_t n = (data[c]>>4) + LZ_MIN_MATCH;
+                size_t disp = (((data[c]&0x0f) << 8) | data[c+1]) + 1;
                 c += 2;
 
-                if(backref > oc) return -1;
-
-                size_t start = oc-backref;
-                size_t end   = start + sz;
-
-                //if( end > decomp_size) return -1;
-
-                for(size_t i = start; i < end; i++, oc++)
-                    buf[oc] = buf[i];
+                if(disp > r.oc || disp > PW_DECOMPRESS_WINDOW) return -1;
+                if(n > size - r.oc) return -1;
 
+                for(; n > 0; n--) {
+                    if(lz_put(&r, WINDOW_AT(r.oc-disp)) != 0) return -1;
+                }
             } else {
                 // 1-byte raw data
-                buf[oc++] = data[c++];
+                if(c >= dlen) return -1;
+                if(lz_put(&r, data[c++]) != 0) return -1;
             }
         }
     }
 
-    if(oc != decomp_size) return -1;
+    if(lz_emit(&r) != 0) return -1;
 
-    //printf("decomp size: %02x\n", oc);
+    return (int)size;
+}
+
+static int copy_sink(const uint8_t *piece, size_t len, size_t offset, void *ctx) {
+    memcpy((uint8_t*)ctx + offset, piece, len);
     return 0;
 }
 
+/*
+ *  One eeprom write: exactly PW_DECOMPRESS_PIECE bytes into `buf`.
+ */
+int pw_decompress_data(uint8_t *data, uint8_t *buf, size_t dlen) {
+    if(data == 0 || buf == 0 || dlen < 4) return -1;
+
+    size_t size = data[1] | data[2] << 8 | (uint32_t)data[3] << 16;
+    if(size != PW_DECOMPRESS_PIECE) return -1;
+
+    return (pw_decompress_stream(data, dlen, copy_sink, buf) < 0)?-1:0;
+}
@@ -6,7 +6,33 @@
 
 /// @file ir/compression.h
 
-void pw_compress_data(uint8_t *data, uint8_t *buf, size_t dlen);
+#define PW_COMPRESS_FAST    0
+#define PW_COMPRESS_NORMAL  1
+#define PW_COMPRESS_BEST    2
+
+#ifndef PW_COMPRESS_LEVEL_DEFAULT
+#define PW_COMPRESS_LEVEL_DEFAULT   PW_COMPRESS_NORMAL
+#endif
+
+#define PW_COMPRESS_FAST_WINDOW 32      // bytes searched back by PW_COMPRESS_FAST
+#define PW_COMPRESS_MAX_INPUT   128     // largest input PW_COMPRESS_BEST parses, one eeprom write
+
+#ifndef PW_DECOMPRESS_WINDOW
+#define PW_DECOMPRESS_WINDOW    256     // power of 2, furthest back-reference the decoder takes
+#endif
+
+#ifndef PW_DECOMPRESS_PIECE
+#define PW_DECOMPRESS_PIECE     128     // output handed to the sink at a time, one eeprom write
+#endif
+
+/*
+ *  Gets decoded output in order, `len` bytes at `offset` into the whole.
+ *  Only valid during the call. Return non-zero to stop decoding.
+ */
+typedef int (*pw_decompress_sink_t)(const uint8_t *piece, size_t len, size_t offset, void *ctx);
+
+size_t pw_compress_data(const uint8_t *data, uint8_t *buf, size_t dlen, size_t buf_len, uint8_t level);
 int  pw_decompress_data(uint8_t *data, uint8_t *buf, size_t dlen);
+int  pw_decompress_stream(const uint8_t *data, size_t dlen, pw_decompress_sink_t sink, void *ctx);
 
 #endif /* PW_COMPRESSION_H */
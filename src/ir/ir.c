@@ -2,13 +2,34 @@
 #include <stdbool.h>
 
 #include <stdio.h>
+#include <string.h>
 
 #include "ir.h"
+#include "ir_ring.h"
+#include "../timer.h"
+#include "../checksum.h"
 
 static comm_state_t g_comm_state = COMM_STATE_DISCONNECTED;
 
 uint8_t session_id[4] = {0xde, 0xad, 0xbe, 0xef};
 
+#ifdef PW_IR_RING
+/*
+ *  Framer state. A frame is whatever arrives before the line goes
+ *  quiet. Anything past the `len` the caller asked for is dropped,
+ *  like a blocking read of `len` bytes would.
+ */
+static uint8_t frame[MAX_PACKET_SIZE];
+static size_t frame_len = 0;
+static bool waiting = false;
+static uint32_t wait_start_us = 0;
+
+static void pw_ir_framer_reset() {
+    frame_len = 0;
+    waiting = false;
+}
+#endif /* PW_IR_RING */
+
 const char* const PW_IR_ERR_NAMES[] = {
     [IR_OK] = "ok",
     [IR_ERR_GENERAL] = "general",
@@ -29,23 +50,54 @@ const char* const PW_IR_ERR_NAMES[] = {
     [IR_ERR_INVALID_MASTER] = "invalid master",
     [IR_ERR_BAD_DATA] = "bad data",
     [IR_ERR_UNHANDLED_ERROR] = "unhandled error",
+    [IR_ERR_AWAITING] = "awaiting",
 };
 
 
+/*
+ *  Checksum is Dmitry's: seed 0x0002, even bytes are the high byte of a
+ *  16-bit word, odd bytes the low byte, with the carries folded back in.
+ *  Bytes 2-3 (the checksum itself) count as zero.
+ *  Both directions do the xor 0xaa and the sum in the same pass, two
+ *  bytes at a time.
+ */
+static uint16_t pw_ir_fold(uint32_t crc) {
+    while(crc>>16) crc = (uint16_t)crc + (crc>>16);
+    return crc;
+}
+
 ir_err_t pw_ir_send_packet(pw_packet_t *packet, size_t len, size_t *pn_write) {
 
     for(uint8_t i = 0; i < 4; i++)
         packet->session_id_bytes[i] = session_id[i];
 
-    uint16_t chk = pw_ir_checksum(packet, len);
+    uint8_t *p = packet->bytes;
+    uint32_t crc = 0x0002;
+    size_t i;
+
+    // header, skipping the checksum word
+    crc += ((uint16_t)p[0]<<8) | p[1];
+    p[0] ^= 0xaa;
+    p[1] ^= 0xaa;
+    for(i = 4; i+1 < len; i += 2) {
+        crc += ((uint16_t)p[i]<<8) | p[i+1];
+        p[i]   ^= 0xaa;
+        p[i+1] ^= 0xaa;
+    }
+    if(i < len) {
+        crc += (uint16_t)p[i]<<8;
+        p[i] ^= 0xaa;
+    }
 
     // Packet checksum little-endian
-    //packet[0x02] = (uint8_t)(chk&0xff);
-    //packet[0x03] = (uint8_t)(chk>>8);
-    packet->le_checksum = chk;
+    uint16_t chk = pw_ir_fold(crc);
+    p[2] = (uint8_t)(chk&0xff) ^ 0xaa;
+    p[3] = (uint8_t)(chk>>8) ^ 0xaa;
 
-    for(size_t i = 0; i < len; i++)
-        packet->bytes[i] ^= 0xaa;
+#ifdef PW_IR_RING
+    // the reply timeout runs from this send
+    waiting = false;
+#endif
 
     int n_write = pw_ir_write(packet->bytes, len);
     *pn_write = (size_t)n_write;
@@ -55,45 +107,133 @@ ir_err_t pw_ir_send_packet(pw_packet_t *packet, size_t len, size_t *pn_write) {
     return IR_OK;
 }
 
-ir_err_t pw_ir_recv_packet(pw_packet_t *packet, size_t len, size_t *pn_read) {
-
-    *pn_read = 0;
-    int n_read = pw_ir_read(packet->bytes, len);
+/*
+ *  Undo the xor and check a received frame of `n` bytes, `len` expected.
+ */
+static ir_err_t pw_ir_decode_packet(pw_packet_t *packet, size_t len, size_t n) {
+    uint8_t *p = packet->bytes;
+    uint32_t crc = 0x0002;
+    uint8_t sess_diff = 0;
+    size_t i = 0;
+
+    // header: cmd, extra, checksum (not summed), session id
+    if(n >= 8) {
+        p[0] ^= 0xaa;
+        p[1] ^= 0xaa;
+        p[2] ^= 0xaa;
+        p[3] ^= 0xaa;
+        crc += ((uint16_t)p[0]<<8) | p[1];
+        for(i = 4; i < 8; i += 2) {
+            p[i]   ^= 0xaa;
+            p[i+1] ^= 0xaa;
+            crc += ((uint16_t)p[i]<<8) | p[i+1];
+            sess_diff |= (p[i] ^ session_id[i-4]) | (p[i+1] ^ session_id[i-3]);
+        }
+    }
 
-    if(n_read <= 0) return IR_ERR_TIMEOUT;
-    *pn_read = (size_t)n_read;
+    // payload, or whatever a short packet has
+    for(; i+1 < n; i += 2) {
+        p[i]   ^= 0xaa;
+        p[i+1] ^= 0xaa;
+        crc += ((uint16_t)p[i]<<8) | p[i+1];
+    }
+    if(i < n) {
+        p[i] ^= 0xaa;
+        crc += (uint16_t)p[i]<<8;
+    }
 
-    //printf("n_read: %lu\n", *pn_read);
-    for(int i = 0; i < n_read; i++)
-        packet->bytes[i] ^= 0xaa;
+    if(n != len && len < MAX_PACKET_SIZE) return IR_ERR_SIZE_MISMATCH;
 
-    if(n_read != len && len < MAX_PACKET_SIZE) return IR_ERR_SIZE_MISMATCH;
+    // a packet this short can't have a checksum to compare with
+    if(n < 8) return IR_ERR_SHORT_PACKET;
 
     // packet chk LE
-    //uint16_t packet_chk = (((uint16_t)packet[3])<<8) + ((uint16_t)packet[2]);
-    uint16_t packet_chk = packet->le_checksum;
-    uint16_t chk = pw_ir_checksum(packet, *pn_read);
+    if(packet->le_checksum != pw_ir_fold(crc)) return IR_ERR_BAD_CHECKSUM;
+
+    // session id is only agreed once we know who is master
+    comm_state_t cs = pw_ir_get_comm_state();
+    if((cs == COMM_STATE_MASTER || cs == COMM_STATE_SLAVE) && sess_diff)
+        return IR_ERR_BAD_SESSID;
+
+    return IR_OK;
+}
 
-    if(packet_chk != chk) return IR_ERR_BAD_CHECKSUM;
 
-    for(size_t i = i; i < 4; i++) {
-        if(packet->session_id_bytes[i] != session_id[i]) return IR_ERR_BAD_SESSID;
+#ifdef PW_IR_RING
+
+ir_err_t pw_ir_poll_packet(pw_packet_t *packet, size_t len, size_t *pn_read) {
+    uint32_t now = (uint32_t)pw_now_us();
+
+    *pn_read = 0;
+    if(len > MAX_PACKET_SIZE) len = MAX_PACKET_SIZE;
+
+    if(!waiting) {
+        waiting = true;
+        wait_start_us = now;
     }
 
-    return IR_OK;
+    frame_len += pw_ir_ring_pop(frame+frame_len, MAX_PACKET_SIZE-frame_len);
+
+    if(frame_len == 0) {
+        if(now - wait_start_us < PW_IR_READ_TIMEOUT_US) return IR_ERR_AWAITING;
+        waiting = false;
+        return IR_ERR_TIMEOUT;
+    }
+
+    if(frame_len < MAX_PACKET_SIZE && pw_ir_ring_idle_us() < PW_IR_FRAME_GAP_US)
+        return IR_ERR_AWAITING;
+
+    size_t n = (frame_len < len)?frame_len:len;
+    memcpy(packet->bytes, frame, n);
+    frame_len = 0;
+    waiting = false;
+
+    *pn_read = n;
+    return pw_ir_decode_packet(packet, len, n);
+}
+
+/*
+ *  Blocking receive for callers that can't come back later.
+ */
+ir_err_t pw_ir_recv_packet(pw_packet_t *packet, size_t len, size_t *pn_read) {
+    ir_err_t err;
+
+    while((err = pw_ir_poll_packet(packet, len, pn_read)) == IR_ERR_AWAITING)
+        pw_ir_delay_ms(1);
+
+    return err;
+}
+
+#else /* PW_IR_RING */
+
+ir_err_t pw_ir_recv_packet(pw_packet_t *packet, size_t len, size_t *pn_read) {
+
+    *pn_read = 0;
+    int n_read = pw_ir_read(packet->bytes, len);
+
+    if(n_read <= 0) return IR_ERR_TIMEOUT;
+    *pn_read = (size_t)n_read;
+
+    return pw_ir_decode_packet(packet, len, (size_t)n_read);
 }
 
+ir_err_t pw_ir_poll_packet(pw_packet_t *packet, size_t len, size_t *pn_read) {
+    return pw_ir_recv_packet(packet, len, pn_read);
+}
+
+#endif /* PW_IR_RING */
+
 
+/*
+ *  Sum of the data as big endian 16-bit words (an odd last byte is the
+ *  high half of its word), carries folded back in.
+ */
 uint16_t pw_ir_checksum_seeded(uint8_t *data, size_t len, uint16_t seed) {
     // Dmitry's palm
-    uint32_t crc = seed;
-    for(size_t i = 0; i < len; i++) {
-        uint16_t v = data[i];
+    pw_sum_t s;
+    pw_checksum_sum(data, len, &s);
 
-        if(!(i&1)) v <<= 8;
-
-        crc += v;
-    }
+    uint32_t crc = seed + (s.even<<8) + s.odd;
 
     while(crc>>16) crc = (uint16_t)crc + (crc>>16);
 
@@ -129,6 +269,13 @@ uint16_t pw_ir_checksum(pw_packet_t *packet, size_t len) {
 
 
 void pw_ir_set_comm_state(comm_state_t s) {
+#ifdef PW_IR_RING
+    // don't let a dead session's bytes leak into the next one
+    if(s == COMM_STATE_DISCONNECTED && g_comm_state != COMM_STATE_DISCONNECTED) {
+        pw_ir_ring_clear();
+        pw_ir_framer_reset();
+    }
+#endif
     g_comm_state = s;
 }
 
@@ -102,6 +102,7 @@ typedef enum {
     IR_ERR_BAD_DATA,
     IR_ERR_INVALID_MASTER,
     IR_ERR_UNHANDLED_ERROR,
+    IR_ERR_AWAITING,    // no complete packet yet, see pw_ir_poll_packet()
     IR_ERR_COUNT,
 } ir_err_t;
 
@@ -125,6 +126,7 @@ extern int pw_ir_write(uint8_t *buf, size_t len);
 
 ir_err_t pw_ir_send_packet(pw_packet_t *packet, size_t len, size_t *n_read);
 ir_err_t pw_ir_recv_packet(pw_packet_t *packet, size_t len, size_t *n_write);
+ir_err_t pw_ir_poll_packet(pw_packet_t *packet, size_t len, size_t *n_read);
 ir_err_t pw_ir_send_advertising_packet();
 
 uint16_t pw_ir_checksum_seeded(uint8_t *data, size_t len, uint16_t seed);
@@ -135,6 +137,18 @@ comm_state_t pw_ir_get_comm_state();
 void pw_ir_die(const char* message);
 void pw_ir_delay_ms(size_t ms);
 
+#ifdef PW_INSTRUMENT
+#include "../instrument.h"
+
+/*
+ *  Count driver traffic per call site, see instrument.h
+ */
+int pw_instr_ir_read(const char *file, const char *func, int line, uint8_t *buf, size_t len);
+int pw_instr_ir_write(const char *file, const char *func, int line, uint8_t *buf, size_t len);
+
+#define pw_ir_read(buf, len)    pw_instr_ir_read(PW_INSTR_HERE, buf, len)
+#define pw_ir_write(buf, len)   pw_instr_ir_write(PW_INSTR_HERE, buf, len)
+#endif /* PW_INSTRUMENT */
 
 #endif /* PW_IR_H */
 
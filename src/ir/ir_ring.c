@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ir_ring.h"
+#include "../timer.h"
+
+/// @file ir/ir_ring.c
+
+#if (PW_IR_RING_SIZE & (PW_IR_RING_SIZE-1)) || PW_IR_RING_SIZE < MAX_PACKET_SIZE
+#error "PW_IR_RING_SIZE must be a power of 2 and hold a whole packet"
+#endif
+
+#define RING_MASK   (PW_IR_RING_SIZE-1)
+
+/*
+ *  `head` is only written by the producer, `tail` only by the consumer.
+ *  Both run freely and are masked on access, so head-tail is the count.
+ */
+static uint8_t ring[PW_IR_RING_SIZE];
+static volatile uint16_t head = 0, tail = 0;
+static volatile uint32_t last_rx_us = 0;
+static volatile uint32_t n_dropped = 0;
+
+void pw_ir_ring_push(uint8_t b) {
+    uint16_t h = head;
+
+    last_rx_us = (uint32_t)pw_now_us();
+
+    if((uint16_t)(h - tail) >= PW_IR_RING_SIZE) {
+        n_dropped++;
+        return;
+    }
+
+    ring[h&RING_MASK] = b;
+    __atomic_thread_fence(__ATOMIC_RELEASE);    // byte before index
+    head = h+1;
+}
+
+void pw_ir_ring_push_buf(const uint8_t *buf, size_t len) {
+    for(size_t i = 0; i < len; i++)
+        pw_ir_ring_push(buf[i]);
+}
+
+size_t pw_ir_ring_count() {
+    return (uint16_t)(head - tail);
+}
+
+size_t pw_ir_ring_pop(uint8_t *buf, size_t len) {
+    uint16_t t = tail;
+    uint16_t n = head - t;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);    // index before bytes
+
+    if(len < n) n = len;
+    for(uint16_t i = 0; i < n; i++)
+        buf[i] = ring[(uint16_t)(t+i)&RING_MASK];
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);    // bytes read before slot is freed
+    tail = t+n;
+    return n;
+}
+
+/*
+ *  How long since the last byte came in.
+ */
+uint32_t pw_ir_ring_idle_us() {
+    return (uint32_t)pw_now_us() - last_rx_us;
+}
+
+uint32_t pw_ir_ring_dropped() {
+    return n_dropped;
+}
+
+/*
+ *  Throw away everything received so far. Consumer side only.
+ */
+void pw_ir_ring_clear() {
+    tail = head;
+}
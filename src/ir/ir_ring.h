@@ -0,0 +1,54 @@
+#ifndef PW_IR_RING_H
+#define PW_IR_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ir.h"
+
+/// @file ir/ir_ring.h
+
+/*
+ *  Receive ring for interrupt-driven IR drivers.
+ *
+ *  The driver's UART rx interrupt calls `pw_ir_ring_push()` for every
+ *  byte it receives (single producer); the core drains the ring from
+ *  the main loop (single consumer). No locks are needed, each side only
+ *  ever writes its own index.
+ *
+ *  When the core is built with PW_IR_RING, `pw_ir_poll_packet()` frames
+ *  packets out of the ring: a frame ends when the line has been quiet
+ *  for PW_IR_FRAME_GAP_US (the protocol has no length field, and the
+ *  peer never answers before we have read its last packet). Until then
+ *  it returns IR_ERR_AWAITING straight away instead of blocking, and
+ *  IR_ERR_TIMEOUT once nothing at all has arrived for
+ *  PW_IR_READ_TIMEOUT_US. `pw_ir_read()` is not used.
+ *
+ *  Without PW_IR_RING, `pw_ir_poll_packet()` is just the blocking
+ *  `pw_ir_recv_packet()`.
+ */
+
+#ifndef PW_IR_RING_SIZE
+#define PW_IR_RING_SIZE     256     // power of 2, at least MAX_PACKET_SIZE
+#endif
+
+#ifndef PW_IR_FRAME_GAP_US
+#define PW_IR_FRAME_GAP_US  500     // ~6 byte times at 115200 baud
+#endif
+
+/*
+ *  Producer side, safe to call from an interrupt.
+ */
+void pw_ir_ring_push(uint8_t b);
+void pw_ir_ring_push_buf(const uint8_t *buf, size_t len);
+
+/*
+ *  Consumer side, main loop only.
+ */
+size_t pw_ir_ring_count();
+size_t pw_ir_ring_pop(uint8_t *buf, size_t len);
+uint32_t pw_ir_ring_idle_us();
+uint32_t pw_ir_ring_dropped();
+void pw_ir_ring_clear();
+
+#endif /* PW_IR_RING_H */
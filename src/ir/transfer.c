@@ -0,0 +1,192 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "transfer.h"
+#include "ir.h"
+#include "compression.h"
+#include "../eeprom.h"
+#include "../eeprom_cache.h"
+#include "../timer.h"
+
+/// @file ir/transfer.c
+
+/*
+ *  Payload and command for an eeprom write of `len` bytes to `addr` on the peer.
+ *  A whole 128-byte aligned page goes out with the compressed write command
+ *  if that makes the packet shorter, anything else goes raw.
+ *  Returns the payload length.
+ */
+size_t pw_transfer_encode_write(uint16_t addr, uint8_t *data, size_t len, uint8_t *pcmd, uint8_t *payload) {
+    if(len == PW_COMPRESS_MAX_INPUT && (addr&0x7f) == 0) {
+        size_t n = pw_compress_data(data, payload, len, len-1, PW_COMPRESS_LEVEL_DEFAULT);
+        if(n > 0) {
+            *pcmd = (uint8_t)(addr&0x80);    // CMD_EEPROM_WRITE_CMP_00/80
+            return n;
+        }
+    }
+
+    *pcmd = (uint8_t)(addr&0xff) + 2; // Need +2 to make it raw write command
+    memcpy(payload, data, len);
+    return len;
+}
+
+/*
+ *  Read and encode the chunk at `t->requested` so it is ready to send.
+ */
+static void pw_transfer_prepare_send(pw_transfer_t *t) {
+    uint8_t raw[PW_TRANSFER_CHUNK_SIZE];
+    uint16_t addr = t->dst + t->requested;
+
+    pw_eeprom_cache_read(t->src + t->requested, raw, PW_TRANSFER_CHUNK_SIZE);
+    t->next_extra = (uint8_t)(addr>>8);
+    t->next_len = pw_transfer_encode_write(addr, raw, PW_TRANSFER_CHUNK_SIZE, &t->next_cmd, t->next_payload);
+}
+
+void pw_transfer_begin(pw_transfer_t *t, pw_transfer_dir_t dir, uint16_t src, uint16_t dst, uint16_t size) {
+    t->src = src;
+    t->dst = dst;
+    t->size = size;
+    t->requested = 0;
+    t->completed = 0;
+    t->dir = dir;
+    t->state = (size > 0)?PW_TRANSFER_SENDING:PW_TRANSFER_DONE;
+    t->packets = 0;
+    t->wire_bytes = 0;
+    t->start_us = pw_now_us();
+    t->end_us = t->start_us;
+
+    if(dir == PW_TRANSFER_SEND && size > 0) {
+        pw_transfer_prepare_send(t);
+    }
+}
+
+static ir_err_t pw_transfer_send_step(pw_transfer_t *t, pw_packet_t *packet) {
+    ir_err_t err;
+    size_t n_rw;
+
+    if(t->state == PW_TRANSFER_SENDING) {
+        packet->cmd = t->next_cmd;
+        packet->extra = t->next_extra;
+        memcpy(packet->payload, t->next_payload, t->next_len);
+
+        pw_ir_delay_ms(PW_TRANSFER_TURNAROUND_MS);
+        err = pw_ir_send_packet(packet, 8+t->next_len, &n_rw);
+        if(err != IR_OK) return err;
+
+        t->packets++;
+        t->wire_bytes += 8+t->next_len;
+        t->requested += PW_TRANSFER_CHUNK_SIZE;
+        t->state = PW_TRANSFER_AWAITING;
+
+        // peer is decoding and writing, get the next one ready meanwhile
+        if(t->requested < t->size) {
+            pw_transfer_prepare_send(t);
+        }
+        return IR_OK;
+    }
+
+    // PW_TRANSFER_AWAITING
+    err = pw_ir_poll_packet(packet, 8, &n_rw);
+    if(err != IR_OK) return err;
+    if(packet->cmd != CMD_EEPROM_WRITE_ACK) return IR_ERR_UNEXPECTED_PACKET;
+
+    t->packets++;
+    t->wire_bytes += n_rw;
+    t->completed = t->requested;
+    t->state = (t->completed < t->size)?PW_TRANSFER_SENDING:PW_TRANSFER_DONE;
+    return IR_OK;
+}
+
+static void pw_transfer_send_read_request(pw_transfer_t *t, pw_packet_t *packet, size_t *pn_rw, ir_err_t *perr) {
+    uint16_t addr = t->src + t->requested;
+    size_t remaining = t->size - t->requested;
+    uint8_t len = (remaining < PW_TRANSFER_CHUNK_SIZE)?remaining:PW_TRANSFER_CHUNK_SIZE;
+
+    packet->cmd = CMD_EEPROM_READ_REQ;
+    packet->extra = EXTRA_BYTE_TO_WALKER;
+    packet->payload[0] = (uint8_t)(addr>>8);
+    packet->payload[1] = (uint8_t)(addr&0xff);
+    packet->payload[2] = len;
+
+    pw_ir_delay_ms(PW_TRANSFER_TURNAROUND_MS);
+    *perr = pw_ir_send_packet(packet, 8+3, pn_rw);
+    if(*perr != IR_OK) return;
+
+    t->packets++;
+    t->wire_bytes += 8+3;
+    t->requested += len;
+}
+
+static ir_err_t pw_transfer_read_step(pw_transfer_t *t, pw_packet_t *packet) {
+    ir_err_t err = IR_OK;
+    size_t n_rw;
+
+    if(t->state == PW_TRANSFER_SENDING) {
+        pw_transfer_send_read_request(t, packet, &n_rw, &err);
+        if(err != IR_OK) return err;
+        t->state = PW_TRANSFER_AWAITING;
+        return IR_OK;
+    }
+
+    // PW_TRANSFER_AWAITING
+    size_t len = t->requested - t->completed;
+    err = pw_ir_poll_packet(packet, 8+len, &n_rw);
+    if(err != IR_OK) return err;
+    if(packet->cmd != CMD_EEPROM_READ_RSP) return IR_ERR_UNEXPECTED_PACKET;
+
+    t->packets++;
+    t->wire_bytes += n_rw;
+
+    uint16_t write_addr = t->dst + t->completed;
+    t->completed = t->requested;
+
+    if(t->completed < t->size) {
+        // ask for the next chunk before spending time on our eeprom
+        uint8_t chunk[PW_TRANSFER_CHUNK_SIZE];
+        memcpy(chunk, packet->payload, len);
+
+        pw_transfer_send_read_request(t, packet, &n_rw, &err);
+        pw_eeprom_cache_write(write_addr, chunk, len);
+        if(err != IR_OK) return err;
+    } else {
+        pw_eeprom_cache_write(write_addr, packet->payload, len);
+        t->state = PW_TRANSFER_DONE;
+    }
+
+    return IR_OK;
+}
+
+ir_err_t pw_transfer_run(pw_transfer_t *t, pw_packet_t *packet, uint32_t budget_us) {
+    uint64_t start = pw_now_us();
+
+    while(t->state == PW_TRANSFER_SENDING || t->state == PW_TRANSFER_AWAITING) {
+        // only give up the loop with a request in flight, so it overlaps whatever runs next
+        if(t->state == PW_TRANSFER_SENDING && pw_now_us() - start > budget_us) break;
+
+        ir_err_t err = (t->dir == PW_TRANSFER_SEND)
+                       ?pw_transfer_send_step(t, packet)
+                       :pw_transfer_read_step(t, packet);
+        if(err != IR_OK) return err;
+
+        if(t->state == PW_TRANSFER_DONE) t->end_us = pw_now_us();
+    }
+
+    return IR_OK;
+}
+
+bool pw_transfer_done(pw_transfer_t *t) {
+    return t->state == PW_TRANSFER_DONE;
+}
+
+/*
+ *  Payload bytes per second from begin to the last ack/data, or so far
+ *  if the job is still running.
+ */
+uint32_t pw_transfer_bytes_per_s(pw_transfer_t *t) {
+    uint64_t end = (t->state == PW_TRANSFER_DONE)?t->end_us:pw_now_us();
+    uint64_t dt = end - t->start_us;
+    if(dt == 0) return 0;
+    return (uint32_t)((uint64_t)t->completed*1000000/dt);
+}
@@ -0,0 +1,77 @@
+#ifndef PW_IR_TRANSFER_H
+#define PW_IR_TRANSFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "ir.h"
+#include "../types.h"
+
+/// @file ir/transfer.h
+
+/*
+ *  Large eeprom transfers to or from the peer as one resumable job.
+ *
+ *  Call `pw_transfer_run()` once per walker_loop() until the job is done.
+ *  Each call moves as many chunks as fit in `budget_us` and returns.
+ *  The job keeps its progress, so an unanswered packet simply carries
+ *  over to the next call.
+ *
+ *  The next chunk is prepared while the peer is busy with the current one:
+ *      send:  the next chunk is read from our eeprom (and compressed)
+ *             right after a write goes out, before waiting for its ACK
+ *      read:  the next read request goes out before the chunk we just
+ *             received is written to our eeprom
+ *
+ *  Sends always move whole chunks. The peer writes 128 bytes per packet
+ *  no matter how short it is, so sizes round up like they always have.
+ */
+
+#define PW_TRANSFER_CHUNK_SIZE      128
+#define PW_TRANSFER_TURNAROUND_MS   1
+
+#ifndef PW_TRANSFER_BUDGET_US
+#define PW_TRANSFER_BUDGET_US       50000   // per pw_transfer_run() call
+#endif
+
+typedef enum {
+    PW_TRANSFER_SEND,   // our eeprom -> peer eeprom
+    PW_TRANSFER_READ,   // peer eeprom -> our eeprom
+} pw_transfer_dir_t;
+
+typedef enum {
+    PW_TRANSFER_IDLE,
+    PW_TRANSFER_SENDING,    // next chunk/request is ready to go out
+    PW_TRANSFER_AWAITING,   // waiting for the peer's ack/data
+    PW_TRANSFER_DONE,
+} pw_transfer_state_t;
+
+typedef struct {
+    uint16_t src, dst;
+    uint16_t size;
+    uint16_t requested;     // bytes sent or asked for
+    uint16_t completed;     // bytes acked or received
+    uint8_t  dir;           // pw_transfer_dir_t
+    uint8_t  state;         // pw_transfer_state_t
+
+    // prepared send packet
+    uint8_t next_cmd;
+    uint8_t next_extra;
+    uint8_t next_len;
+    uint8_t next_payload[PW_TRANSFER_CHUNK_SIZE];
+
+    // throughput
+    uint64_t start_us, end_us;
+    uint32_t packets;
+    uint32_t wire_bytes;
+} pw_transfer_t;
+
+void pw_transfer_begin(pw_transfer_t *t, pw_transfer_dir_t dir, uint16_t src, uint16_t dst, uint16_t size);
+ir_err_t pw_transfer_run(pw_transfer_t *t, pw_packet_t *packet, uint32_t budget_us);
+bool pw_transfer_done(pw_transfer_t *t);
+uint32_t pw_transfer_bytes_per_s(pw_transfer_t *t);
+
+size_t pw_transfer_encode_write(uint16_t addr, uint8_t *data, size_t len, uint8_t *pcmd, uint8_t *payload);
+
+#endif /* PW_IR_TRANSFER_H */
@@ -15,7 +15,13 @@
 #include "utils.h"
 #include "ir/ir.h"
 #include "eeprom.h"
+#include "eeprom_cache.h"
+#include "eeprom_async.h"
+#include "eeprom_bank.h"
+#include "eeprom_erase.h"
 #include "eeprom_map.h"
+#include "walk_copy.h"
+#include "health_journal.h"
 #include "accel.h"
 
 struct {
@@ -35,13 +41,21 @@ void walker_setup() {
     pw_screen_init();
     pw_audio_init();
     pw_eeprom_init();
+    pw_eeprom_bank_init();
     pw_accel_init();
     pw_srand(0x12345678);
 
+    pw_eeprom_erase_init();
+
     if(!pw_eeprom_check_for_nintendo()) {
         pw_eeprom_reset(true, true);
     }
 
+    // a walk start copy was cut short, finish it before anything reads the route
+    if(pw_walk_copy_resume()) {
+        pw_walk_copy_wait();
+    }
+
     pw_eeprom_reliable_read(
         PW_EEPROM_ADDR_IDENTITY_DATA_1,
         PW_EEPROM_ADDR_IDENTITY_DATA_2,
@@ -49,19 +63,8 @@ void walker_setup() {
         sizeof(walker_info_cache)
     );
 
-    pw_eeprom_reliable_read(
-        PW_EEPROM_ADDR_HEALTH_DATA_1,
-        PW_EEPROM_ADDR_HEALTH_DATA_2,
-        (uint8_t*)&health_data_cache,
-        sizeof(health_data_cache)
-    );
-
-    // swap BE in eeprom to LE in host
-    health_data_cache.today_steps   = swap_bytes_u32(health_data_cache.today_steps);
-    health_data_cache.total_steps   = swap_bytes_u32(health_data_cache.total_steps);
-    health_data_cache.last_sync     = swap_bytes_u32(health_data_cache.last_sync);
-    health_data_cache.total_days    = swap_bytes_u16(health_data_cache.total_days);
-    health_data_cache.current_watts = swap_bytes_u16(health_data_cache.current_watts);
+    pw_health_load();
+    pw_route_index_build();
 
     pw_audio_volume = (health_data_cache.settings&SETTINGS_SOUND_MASK)>>SETTINGS_SOUND_OFFSET;
 
@@ -119,6 +122,18 @@ void walker_loop() {
         screen_flags.frame = (screen_flags.frame+1)%4;
         PW_CLR_REQUEST(current_state->requests, PW_REQUEST_REDRAW);
     }
+
+    // Push whatever changed on the framebuffer this iteration
+    pw_screen_flush();
+
+    // Nothing time-critical left this iteration: move queued eeprom
+    // requests on, journal step changes, check a reliable record read
+    // earlier, wipe a lazily erased page and write back eeprom changes
+    pw_eeprom_async_poll(PW_EEPROM_ASYNC_BUDGET_US);
+    pw_health_idle();
+    pw_eeprom_reliable_idle();
+    pw_eeprom_erase_idle();
+    pw_eeprom_cache_flush();
 }
 
 void pw_state_handle_input(uint8_t b) {
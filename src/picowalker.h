@@ -4,5 +4,7 @@
 /// @file picowalker.h
 
 void walker_entry();
+void walker_setup();
+void walker_loop();
 
 #endif /* PW_PICOWALKER_H */
@@ -4,6 +4,7 @@
 
 #include "screen.h"
 #include "eeprom.h"
+#include "eeprom_cache.h"
 #include "eeprom_map.h"
 #include "globals.h"
 
@@ -16,63 +17,92 @@
 
 void pw_screen_draw_from_eeprom(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t addr, size_t len) {
     pw_img_t img = {.height=h, .width=w, .data=eeprom_buf, .size=len};
-    pw_eeprom_read(addr, eeprom_buf, len);
+    pw_eeprom_cache_read(addr, eeprom_buf, len);
+    pw_screen_draw_img(&img, x, y);
+}
+
+/*
+ *  The digit strip "0123456789:-/" is drawn on most screens, so keep
+ *  it in RAM and build whole numbers in `glyph_line` before handing
+ *  them to the driver in one go.
+ *  Glyphs are 8x16, i.e. two 8-row strips of 16 bytes each.
+ */
+#define GLYPH_INDEX_COLON   10
+#define GLYPH_LINE_MAX      10  // enough for any uint32_t
+#define GLYPH_STRIP_SIZE    (PW_EEPROM_SIZE_IMG_CHAR/2)
+
+static uint8_t glyph_atlas[PW_EEPROM_SIZE_IMG_DIGITS];
+static bool glyph_atlas_loaded = false;
+static uint8_t glyph_line[GLYPH_LINE_MAX*PW_EEPROM_SIZE_IMG_CHAR];
+
+void pw_screen_invalidate_glyphs() {
+    glyph_atlas_loaded = false;
+}
+
+static void glyph_line_put(size_t pos, size_t n_glyphs, uint8_t glyph) {
+    if(!glyph_atlas_loaded) {
+        pw_eeprom_cache_read(PW_EEPROM_ADDR_IMG_DIGITS, glyph_atlas, PW_EEPROM_SIZE_IMG_DIGITS);
+        glyph_atlas_loaded = true;
+    }
+
+    const uint8_t *src = &glyph_atlas[glyph*PW_EEPROM_SIZE_IMG_CHAR];
+    size_t stride = n_glyphs*GLYPH_STRIP_SIZE;
+
+    memcpy(&glyph_line[pos*GLYPH_STRIP_SIZE], &src[0], GLYPH_STRIP_SIZE);
+    memcpy(&glyph_line[stride + pos*GLYPH_STRIP_SIZE], &src[GLYPH_STRIP_SIZE], GLYPH_STRIP_SIZE);
+}
+
+static void glyph_line_draw(size_t n_glyphs, size_t x, size_t y) {
+    pw_img_t img = {
+        .width=8*n_glyphs, .height=16,
+        .data=glyph_line,
+        .size=n_glyphs*PW_EEPROM_SIZE_IMG_CHAR
+    };
     pw_screen_draw_img(&img, x, y);
 }
 
 void pw_screen_draw_integer(uint32_t n, size_t right_x, size_t y) {
+    uint8_t digits[GLYPH_LINE_MAX];
+    size_t n_digits = 0;
 
-    size_t x = right_x;
     uint32_t m = n;
     do {
-        size_t idx = m%10;
+        digits[n_digits++] = m%10;
         m = m/10;
-        x -= 8;
-        pw_screen_draw_from_eeprom(
-            x, y,
-            8, 16,
-            PW_EEPROM_ADDR_IMG_DIGITS+PW_EEPROM_SIZE_IMG_CHAR*idx,
-            PW_EEPROM_SIZE_IMG_CHAR
-        );
     } while(m>0);
+
+    for(size_t i = 0; i < n_digits; i++) {
+        glyph_line_put(i, n_digits, digits[n_digits-1-i]);
+    }
+
+    glyph_line_draw(n_digits, right_x-8*n_digits, y);
 }
 
 void pw_screen_draw_time(uint8_t hour, uint8_t minute, uint8_t second, size_t x, size_t y) {
-    pw_screen_draw_subtime(hour, x, y, true);
-    x += 24;
-    pw_screen_draw_subtime(minute, x, y, true);
-    x += 24;
-    pw_screen_draw_subtime(second, x, y, false);
+    const size_t n = 8;     // "hh:mm:ss"
+
+    glyph_line_put(0, n, hour/10);
+    glyph_line_put(1, n, hour%10);
+    glyph_line_put(2, n, GLYPH_INDEX_COLON);
+    glyph_line_put(3, n, minute/10);
+    glyph_line_put(4, n, minute%10);
+    glyph_line_put(5, n, GLYPH_INDEX_COLON);
+    glyph_line_put(6, n, second/10);
+    glyph_line_put(7, n, second%10);
+
+    glyph_line_draw(n, x, y);
 }
 
 void pw_screen_draw_subtime(uint8_t n, size_t x, size_t y, bool draw_colon) {
-    uint8_t idx;
-
-    idx = n/10;
-    pw_screen_draw_from_eeprom(
-        x, y,
-        8, 16,
-        PW_EEPROM_ADDR_IMG_DIGITS+PW_EEPROM_SIZE_IMG_CHAR*idx,
-        PW_EEPROM_SIZE_IMG_CHAR
-    );
-
-    x += 8;
-    idx = n%10;
-    pw_screen_draw_from_eeprom(
-        x, y,
-        8, 16,
-        PW_EEPROM_ADDR_IMG_DIGITS+PW_EEPROM_SIZE_IMG_CHAR*idx,
-        PW_EEPROM_SIZE_IMG_CHAR
-    );
+    size_t n_glyphs = draw_colon?3:2;
+
+    glyph_line_put(0, n_glyphs, n/10);
+    glyph_line_put(1, n_glyphs, n%10);
     if(draw_colon) {
-        x += 8;
-        pw_screen_draw_from_eeprom(
-            x, y,
-            8, 16,
-            PW_EEPROM_ADDR_IMG_CHAR_COLON,
-            PW_EEPROM_SIZE_IMG_CHAR
-        );
+        glyph_line_put(2, n_glyphs, GLYPH_INDEX_COLON);
     }
+
+    glyph_line_draw(n_glyphs, x, y);
 }
 
 // always draws at x=0
@@ -84,7 +114,7 @@ void pw_screen_draw_message(screen_pos_t y, uint8_t message_index, screen_pos_t
     eeprom_addr_t addr = PW_EEPROM_ADDR_TEXT_CONNECTING + message_index * PW_EEPROM_SIZE_TEXT_CONNECTING;
     size_t sz = PW_EEPROM_SIZE_TEXT_CONNECTING*h/16;
 
-    pw_eeprom_read(addr, eeprom_buf, sz);
+    pw_eeprom_cache_read(addr, eeprom_buf, sz);
 
     pw_img_t img = {
         .width=SCREEN_WIDTH, .height=h,
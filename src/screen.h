@@ -64,6 +64,18 @@ extern void pw_screen_fill_area(
     screen_colour_t colour
 );
 
+/*
+ *  Only called when the core is built with PW_SCREEN_FRAMEBUFFER.
+ *  Copy a region of the core framebuffer (see framebuffer.h) to the LCD.
+ *  `y` and `height` are multiples of 8. `fb` is the whole framebuffer,
+ *  so a strip starts every SCREEN_WIDTH*2 bytes.
+ */
+extern void pw_screen_blit_region(
+    const uint8_t *fb,
+    screen_pos_t x, screen_pos_t y,
+    screen_pos_t width, screen_pos_t height
+);
+
 /*
  *  Derived functions
  */
@@ -77,6 +89,46 @@ void pw_screen_draw_integer(uint32_t n, size_t right_x, size_t y);
 void pw_screen_draw_time(uint8_t hour, uint8_t minute, uint8_t second, size_t x, size_t y);
 void pw_screen_draw_subtime(uint8_t n, size_t x, size_t y, bool draw_colon);
 void pw_screen_draw_message(screen_pos_t y, uint8_t message_index, screen_pos_t h);
+void pw_screen_invalidate_glyphs();
+void pw_screen_flush();
+
+#ifdef PW_SCREEN_FRAMEBUFFER
+#include "framebuffer.h"
+
+/*
+ *  Draw into the core framebuffer instead of straight to the driver
+ */
+#define pw_screen_draw_img          pw_fb_draw_img
+#define pw_screen_clear_area        pw_fb_clear_area
+#define pw_screen_draw_horiz_line   pw_fb_draw_horiz_line
+#define pw_screen_draw_text_box     pw_fb_draw_text_box
+#define pw_screen_clear             pw_fb_clear
+#define pw_screen_fill_area         pw_fb_fill_area
+
+#ifdef PW_INSTRUMENT
+#include "instrument.h"
+
+void pw_instr_screen_blit_region(const char *file, const char *func, int line,
+                                 const uint8_t *fb, screen_pos_t x, screen_pos_t y,
+                                 screen_pos_t width, screen_pos_t height);
+
+#define pw_screen_blit_region(fb, x, y, w, h)   pw_instr_screen_blit_region(PW_INSTR_HERE, fb, x, y, w, h)
+#endif /* PW_INSTRUMENT */
+
+#elif defined(PW_INSTRUMENT)
+#include "instrument.h"
+
+/*
+ *  Count driver traffic per call site, see instrument.h
+ */
+void pw_instr_screen_draw_img(const char *file, const char *func, int line,
+                              pw_img_t *img, screen_pos_t x, screen_pos_t y);
+void pw_instr_screen_clear_area(const char *file, const char *func, int line,
+                                screen_pos_t x, screen_pos_t y,
+                                screen_pos_t width, screen_pos_t height);
 
+#define pw_screen_draw_img(img, x, y)       pw_instr_screen_draw_img(PW_INSTR_HERE, img, x, y)
+#define pw_screen_clear_area(x, y, w, h)    pw_instr_screen_clear_area(PW_INSTR_HERE, x, y, w, h)
+#endif /* PW_SCREEN_FRAMEBUFFER, PW_INSTRUMENT */
 
 #endif /* PW_SCREEN_H */
@@ -29,6 +29,7 @@ const char* const state_strings[N_STATES] = {
     [STATE_SETTINGS]        = "Settings",
     [STATE_ERROR]           = "Error",
     [STATE_FIRST_COMMS]     = "First connect",
+    [STATE_BATTLE]          = "Battle",
 };
 
 // TODO: change function sigs
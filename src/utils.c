@@ -1,120 +1,128 @@
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 #include "utils.h"
 #include "states.h"
 #include "types.h"
 #include "eeprom_map.h"
 #include "eeprom.h"
+#include "eeprom_cache.h"
 
 extern uint16_t swap_bytes_u16(uint16_t x);
 extern uint32_t swap_bytes_u32(uint32_t x);
 
+static pw_detailed_inventory_t inv_detailed;
+static uint8_t inv_received = 0;
+static bool inv_valid = false;
+
 /*
- * Sets sv->reg{a,b,c}
+ *  Species and item ids of the route slots, so the battle and dowsing
+ *  paths don't have to read and search the route data every time.
  *
- * reg_a = [0]=walking_mon, [1..3]=caught_pokemon, [4]=event_pokemon
- * reg_b = [1..3]=found_items, [4]=event_item
- * reg_c = [0..3]=stamps
+ *  route_species[] is indexed by `pokemon_index_t`, route_items[] by
+ *  item index (10 = event item).
  */
-void pw_read_inventory(pw_brief_inventory_t *brief, pw_detailed_inventory_t *detailed) {
-    if(!brief || !detailed) return;
+static uint16_t route_species[N_PIDX];
+static uint16_t route_items[11];
+static bool route_valid = false;
 
-    *brief = (pw_brief_inventory_t) {
-        0
+/*
+ *  Everything the inventory is built from.
+ */
+static const struct {
+    eeprom_addr_t addr;
+    uint16_t len;
+} inv_regions[] = {
+    {PW_EEPROM_ADDR_ROUTE_INFO, sizeof(pokemon_summary_t)},
+    {PW_EEPROM_ADDR_RECEIVED_BITFIELD, 1},
+    {PW_EEPROM_ADDR_EVENT_POKEMON_BASIC_DATA, sizeof(pokemon_summary_t)},
+    {PW_EEPROM_ADDR_EVENT_ITEM, PW_EEPROM_SIZE_EVENT_ITEM},
+    {PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY, PW_EEPROM_ADDR_PEER_PLAY_ITEMS+PW_EEPROM_SIZE_PEER_PLAY_ITEMS-PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY},
+};
+
+static void inventory_load() {
+    pokemon_summary_t walking_pokemon, caught_pokemon[3], event_pokemon;
+    uint16_t le_event_item;
+
+    struct {
+        uint16_t le_item;
+        uint16_t pad;
+    } items[3], gifted[10];
+
+    // in address order, so the ones close together are read in one go
+    const pw_eeprom_seg_t segs[] = {
+        {PW_EEPROM_ADDR_ROUTE_INFO, sizeof(walking_pokemon), (uint8_t*)&walking_pokemon},
+        {PW_EEPROM_ADDR_RECEIVED_BITFIELD, 1, &inv_received},
+        {PW_EEPROM_ADDR_EVENT_POKEMON_BASIC_DATA, sizeof(event_pokemon), (uint8_t*)&event_pokemon},
+        {PW_EEPROM_ADDR_EVENT_ITEM+6, 2, (uint8_t*)&le_event_item},  // ignore first 6 bytes of zeroes
+        {PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY, PW_EEPROM_SIZE_CAUGHT_POKEMON_SUMMARY, (uint8_t*)caught_pokemon},
+        {PW_EEPROM_ADDR_OBTAINED_ITEMS, PW_EEPROM_SIZE_OBTAINED_ITEMS, (uint8_t*)items},
+        {PW_EEPROM_ADDR_PEER_PLAY_ITEMS, PW_EEPROM_SIZE_PEER_PLAY_ITEMS, (uint8_t*)gifted},
     };
-    *detailed = (pw_detailed_inventory_t) {
+    pw_eeprom_cache_readv(segs, sizeof(segs)/sizeof(segs[0]));
+
+    inv_detailed = (pw_detailed_inventory_t) {
         0
     };
 
-    pokemon_summary_t caught_pokemon[3];
-
-    // walking pokemon
-    pw_eeprom_read(PW_EEPROM_ADDR_ROUTE_INFO, (uint8_t*)(caught_pokemon), sizeof(pokemon_summary_t));
-
-    detailed->walking_pokemon = caught_pokemon[0].le_species;
-    if(caught_pokemon[0].le_species != 0 && caught_pokemon[0].le_species != 0xffff) {
-        brief->caught_pokemon |= INV_WALKING_POKEMON;
-    }
-
-    // normal caught pokemon
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_CAUGHT_POKEMON_SUMMARY,
-        (uint8_t*)caught_pokemon,
-        PW_EEPROM_SIZE_CAUGHT_POKEMON_SUMMARY
-    );
-
+    inv_detailed.walking_pokemon = walking_pokemon.le_species;
     for(uint8_t i = 0; i < 3; i++) {
-        detailed->caught_pokemon[i] = caught_pokemon[i].le_species;
-        if(caught_pokemon[i].le_species != 0 && caught_pokemon[i].le_species != 0xffff) {
-            brief->caught_pokemon |= (1<<(i+1));
-        }
+        inv_detailed.caught_pokemon[i] = caught_pokemon[i].le_species;
+        inv_detailed.dowsed_items[i] = items[i].le_item;
+    }
+    inv_detailed.event_pokemon = event_pokemon.le_species;
+    inv_detailed.event_item = le_event_item;
+    for(size_t i = 0; i < 10; i++) {
+        inv_detailed.gifted_items[i] = gifted[i].le_item;
     }
 
-    // event pokemon
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_EVENT_POKEMON_BASIC_DATA,
-        (uint8_t*)(caught_pokemon),
-        sizeof(pokemon_summary_t)
-    );
+    inv_valid = true;
+}
 
-    detailed->event_pokemon = caught_pokemon[0].le_species;
-    if(caught_pokemon[0].le_species != 0 && caught_pokemon[0].le_species != 0xffff) {
-        brief->caught_pokemon |= INV_EXTRA_POKEMON;
-    }
+static inline bool inv_present(uint16_t id) {
+    return id != 0 && id != 0xffff;
+}
 
+/*
+ * Sets sv->reg{a,b,c}
+ *
+ * reg_a = [0]=walking_mon, [1..3]=caught_pokemon, [4]=event_pokemon
+ * reg_b = [1..3]=found_items, [4]=event_item
+ * reg_c = [0..3]=stamps
+ *
+ * The inventory is kept in RAM. It is only read from the eeprom the
+ * first time and after `pw_inventory_invalidate()`, code that changes a
+ * single entry calls `pw_inventory_set()` instead.
+ */
+void pw_read_inventory(pw_brief_inventory_t *brief, pw_detailed_inventory_t *detailed) {
+    if(!brief || !detailed) return;
 
-    struct {
-        uint16_t le_item;
-        uint16_t pad;
-    } items[10];
+    if(!inv_valid) inventory_load();
 
-    // normal dowsing items
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_OBTAINED_ITEMS,
-        (uint8_t*)(items),
-        PW_EEPROM_SIZE_OBTAINED_ITEMS
-    );
+    *detailed = inv_detailed;
+    *brief = (pw_brief_inventory_t) {
+        0
+    };
+    brief->received_bitfield = inv_received;
 
+    // walking pokemon, normal caught pokemon, event pokemon
+    if(inv_present(detailed->walking_pokemon)) brief->caught_pokemon |= INV_WALKING_POKEMON;
     for(uint8_t i = 0; i < 3; i++) {
-        detailed->dowsed_items[i] = items[i].le_item;
-        if(items[i].le_item != 0 && items[i].le_item != 0xffff) {
-            brief->dowsed_items |= (1<<(i+1));
-        }
+        if(inv_present(detailed->caught_pokemon[i])) brief->caught_pokemon |= (1<<(i+1));
     }
+    if(inv_present(detailed->event_pokemon)) brief->caught_pokemon |= INV_EXTRA_POKEMON;
 
-    // event dowsing item
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_EVENT_ITEM+6,    // ignore first 6 bytes of zeroes
-        (uint8_t*)items,
-        2
-    );
-
-    detailed->event_item = items[0].le_item;
-    if(items[0].le_item != 0 && items[0].le_item != 0xffff) {
-        brief->dowsed_items |= INV_EXTRA_ITEM;
+    // normal dowsing items, event dowsing item
+    for(uint8_t i = 0; i < 3; i++) {
+        if(inv_present(detailed->dowsed_items[i])) brief->dowsed_items |= (1<<(i+1));
     }
-
-
-    // special inventory (stamps, etc)
-    uint8_t special_inventory;
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_RECEIVED_BITFIELD,
-        &(brief->received_bitfield),
-        1
-    );
+    if(inv_present(detailed->event_item)) brief->dowsed_items |= INV_EXTRA_ITEM;
 
     // gifted items from peer play
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_PEER_PLAY_ITEMS,
-        (uint8_t*)items,
-        PW_EEPROM_SIZE_PEER_PLAY_ITEMS
-    );
-
     brief->n_peer_play_items = 0;
     for(size_t i = 0; i < 10; i++) {
-        detailed->gifted_items[i] = items[i].le_item;
-        if(items[i].le_item != 0 && items[i].le_item != 0xffff) {
+        if(inv_present(detailed->gifted_items[i])) {
             brief->n_peer_play_items++;
             brief->peer_play_items |= 1<<i;
         }
@@ -134,6 +142,37 @@ void pw_read_inventory(pw_brief_inventory_t *brief, pw_detailed_inventory_t *det
 
 }
 
+/*
+ * Entry `idx` (as in `packed`) has just been written to the eeprom.
+ */
+void pw_inventory_set(packed_index_t idx, uint16_t le_id) {
+    if(idx >= N_PACKED_INDICES || idx == PI_EMPTY_SLOT) return;
+    inv_detailed.entries[idx] = le_id;
+
+    // the route index looks at the same event slots
+    if(idx == PI_EXTRA_POKEMON) route_species[PIDX_EXTRA] = le_id;
+    if(idx == PI_EXTRA_ITEM) route_items[10] = le_id;
+}
+
+/*
+ * [addr, addr+len) changed some other way, re-read on next use if that
+ * touches the inventory.
+ */
+void pw_inventory_invalidate(eeprom_addr_t addr, size_t len) {
+    uint32_t end = (uint32_t)addr + len;
+
+    for(size_t i = 0; i < sizeof(inv_regions)/sizeof(inv_regions[0]); i++) {
+        if(addr < inv_regions[i].addr+inv_regions[i].len && end > inv_regions[i].addr) {
+            inv_valid = false;
+            return;
+        }
+    }
+}
+
+void pw_inventory_invalidate_all() {
+    inv_valid = false;
+}
+
 void pw_pokemon_index_to_small_sprite(pokemon_index_t idx, uint8_t *buf, uint8_t frame) {
     eeprom_addr_t addr;
 
@@ -162,7 +201,7 @@ void pw_pokemon_index_to_small_sprite(pokemon_index_t idx, uint8_t *buf, uint8_t
     }
     }
 
-    pw_eeprom_read(addr, buf, PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED_FRAME);
+    pw_eeprom_cache_read(addr, buf, PW_EEPROM_SIZE_IMG_POKEMON_SMALL_ANIMATED_FRAME);
 
 }
 
@@ -193,7 +232,7 @@ void pw_pokemon_index_to_name(pokemon_index_t idx, uint8_t *buf) {
     }
     }
 
-    pw_eeprom_read(addr, buf, PW_EEPROM_SIZE_TEXT_POKEMON_NAME);
+    pw_eeprom_cache_read(addr, buf, PW_EEPROM_SIZE_TEXT_POKEMON_NAME);
 }
 
 
@@ -211,7 +250,52 @@ void pw_item_index_to_name(uint8_t idx, uint8_t *buf) {
         return;
     }
 
-    pw_eeprom_read(addr, buf, PW_EEPROM_SIZE_TEXT_ITEM_NAME_SINGLE);
+    pw_eeprom_cache_read(addr, buf, PW_EEPROM_SIZE_TEXT_ITEM_NAME_SINGLE);
+}
+
+static const struct {
+    eeprom_addr_t addr;
+    uint16_t len;
+} route_regions[] = {
+    {PW_EEPROM_ADDR_ROUTE_INFO, PW_EEPROM_SIZE_ROUTE_INFO},
+    {PW_EEPROM_ADDR_EVENT_POKEMON_BASIC_DATA, PW_EEPROM_SIZE_EVENT_POKEMON_BASIC_DATA},
+    {PW_EEPROM_ADDR_EVENT_ITEM, PW_EEPROM_SIZE_EVENT_ITEM},
+};
+
+/*
+ *  Read the route slots into RAM. Called at boot and once the walk start
+ *  copy is done, and on the next lookup after an invalidate.
+ */
+void pw_route_index_build() {
+    pokemon_summary_t walking, route[3], event;
+
+    const pw_eeprom_seg_t segs[] = {
+        {PW_EEPROM_ADDR_ROUTE_INFO, sizeof(walking), (uint8_t*)&walking},
+        {PW_EEPROM_ADDR_ROUTE_POKEMON, sizeof(route), (uint8_t*)route},
+        {PW_EEPROM_ADDR_ROUTE_ITEMS, PW_EEPROM_SIZE_ROUTE_ITEMS, (uint8_t*)route_items},
+        {PW_EEPROM_ADDR_EVENT_POKEMON_BASIC_DATA, sizeof(event), (uint8_t*)&event},
+        {PW_EEPROM_ADDR_EVENT_ITEM+6, 2, (uint8_t*)&route_items[10]},
+    };
+    pw_eeprom_cache_readv(segs, sizeof(segs)/sizeof(segs[0]));
+
+    route_species[PIDX_WALKING] = walking.le_species;
+    for(size_t i = 0; i < 3; i++) {
+        route_species[PIDX_OPTION_A+i] = route[i].le_species;
+    }
+    route_species[PIDX_EXTRA] = event.le_species;
+
+    route_valid = true;
+}
+
+void pw_route_index_invalidate(eeprom_addr_t addr, size_t len) {
+    uint32_t end = (uint32_t)addr + len;
+
+    for(size_t i = 0; i < sizeof(route_regions)/sizeof(route_regions[0]); i++) {
+        if(addr < route_regions[i].addr+route_regions[i].len && end > route_regions[i].addr) {
+            route_valid = false;
+            return;
+        }
+    }
 }
 
 /**
@@ -223,28 +307,10 @@ void pw_item_index_to_name(uint8_t idx, uint8_t *buf) {
  *  @return `pokemon_index_t` containing which route pokemon slot it is
  */
 pokemon_index_t pw_pokemon_id_to_pokemon_index(uint16_t id) {
-    pokemon_summary_t pokes[N_PIDX];
-
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_ROUTE_INFO+0x0000, // offset 0 = current pokemon
-        (uint8_t*)(&pokes[0]),
-        sizeof(pokemon_summary_t)
-    );
-
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_ROUTE_POKEMON,
-        (uint8_t*)(&pokes[1]),
-        3*sizeof(pokemon_summary_t)
-    );
-
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_EVENT_POKEMON_BASIC_DATA, // in inventory so look here for both gifted and special pokemon
-        (uint8_t*)(&pokes[4]),
-        sizeof(pokemon_summary_t)
-    );
+    if(!route_valid) pw_route_index_build();
 
     for(size_t i = 0; i < N_PIDX; i++) {
-        if(pokes[i].le_species == id) return (pokemon_index_t)i;
+        if(route_species[i] == id) return (pokemon_index_t)i;
     }
 
     // unreachable, hopefully
@@ -256,23 +322,10 @@ pokemon_index_t pw_pokemon_id_to_pokemon_index(uint16_t id) {
  * Convert item id into index of route-available items
  */
 uint8_t pw_item_id_to_item_index(uint16_t id) {
-
-    uint16_t items[11];
-
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_ROUTE_ITEMS,
-        (uint8_t*)items,
-        PW_EEPROM_SIZE_ROUTE_ITEMS
-    );
-
-    pw_eeprom_read(
-        PW_EEPROM_ADDR_EVENT_ITEM+0x0006, // in inventory, so look here for gifted and special item.
-        (uint8_t*)(&items[10]),
-        2
-    );
+    if(!route_valid) pw_route_index_build();
 
     for(size_t i = 0; i < 11; i++) {
-        if(items[i] == id) return (uint8_t)i;
+        if(route_items[i] == id) return (uint8_t)i;
     }
 
     // unreachable, hopefully
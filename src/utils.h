@@ -85,10 +85,15 @@ inline uint32_t swap_bytes_u32(uint32_t x) {
 }
 
 void pw_read_inventory(pw_brief_inventory_t *brief, pw_detailed_inventory_t *detailed);
+void pw_inventory_set(packed_index_t idx, uint16_t le_id);
+void pw_inventory_invalidate(eeprom_addr_t addr, size_t len);
+void pw_inventory_invalidate_all();
 
 void pw_pokemon_index_to_small_sprite(pokemon_index_t idx, uint8_t *buf, uint8_t frame);
 void pw_pokemon_index_to_name(pokemon_index_t idx, uint8_t *buf);
 void pw_item_index_to_name(uint8_t idx, uint8_t *buf);
+void pw_route_index_build();
+void pw_route_index_invalidate(eeprom_addr_t addr, size_t len);
 pokemon_index_t pw_pokemon_id_to_pokemon_index(uint16_t id);
 uint8_t pw_item_id_to_item_index(uint16_t id);
 
@@ -0,0 +1,177 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "walk_copy.h"
+#include "eeprom_async.h"
+#include "eeprom_cache.h"
+#include "eeprom_bank.h"
+#include "eeprom_erase.h"
+#include "eeprom_map.h"
+#include "eeprom.h"
+#include "utils.h"
+
+/// @file walk_copy.c
+
+typedef struct {
+    eeprom_addr_t src;
+    eeprom_addr_t dst;
+    uint16_t size;
+} copy_section_t;
+
+/*
+ *  Team data, then the peer play regions that share the staging bank
+ *  with the route. Those are copied to the same place in the live bank,
+ *  so they read the same once the banks swap.
+ */
+static const copy_section_t sections[] = {
+    {PW_EEPROM_ADDR_TEAM_DATA_STAGING, PW_EEPROM_ADDR_TEAM_DATA_STRUCT, PW_EEPROM_SIZE_TEAM_DATA_STRUCT},
+    {
+        PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA,
+        PW_EEPROM_BANK_TWIN(PW_EEPROM_ADDR_CURRENT_PEER_TEAM_DATA),
+        PW_EEPROM_SIZE_CURRENT_PEER_TEAM_DATA
+    },
+    {
+        // peer sprite, name and peer play data
+        PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL,
+        PW_EEPROM_BANK_TWIN(PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL),
+        PW_EEPROM_ADDR_CURRENT_PEER_DATA+PW_EEPROM_SIZE_CURRENT_PEER_DATA - PW_EEPROM_ADDR_IMG_CURRENT_PEER_POKEMON_ANIMATED_SMALL
+    },
+};
+#define N_SECTIONS  (sizeof(sections)/sizeof(sections[0]))
+
+#define SECTION_PAGES(s)    (((s)->size + PW_EEPROM_PAGE_SIZE-1)/PW_EEPROM_PAGE_SIZE)
+
+static pw_eeprom_req_t req = {.state = PW_EEPROM_REQ_IDLE};
+static uint8_t pages_done = 0;
+static uint8_t pages_req = 0;
+static uint8_t target_bank = 0;
+
+static void save_record(uint8_t marker, uint8_t pages) {
+    uint8_t record[PW_WALK_COPY_SIZE_RECORD] = {
+        marker,
+        pages | (target_bank?PW_WALK_COPY_FLAG_BANK:0)
+    };
+
+    pw_eeprom_reliable_write(
+        PW_EEPROM_ADDR_COPY_MARKER_1,
+        PW_EEPROM_ADDR_COPY_MARKER_2,
+        record,
+        PW_WALK_COPY_SIZE_RECORD
+    );
+    pw_eeprom_cache_flush();
+}
+
+static void step_done(pw_eeprom_req_t *r, void *ctx);
+
+/*
+ *  Everything copied: make the staged route live, then drop the record.
+ *
+ *  The met peers sit inside the staging bank too, and a walk start wipes
+ *  them, so they aren't copied over but marked for wiping now. Any
+ *  earlier and the wipe could land on the staged route.
+ */
+static void finish() {
+    pw_eeprom_erase_lazy(PW_EEPROM_ADDR_MET_PEER_DATA, PW_EEPROM_SIZE_MET_PEER_DATA);
+    pw_eeprom_bank_select(target_bank);
+    pw_inventory_invalidate(PW_EEPROM_ADDR_ROUTE_INFO, PW_EEPROM_BANK_SIZE);
+    pw_route_index_build();
+    save_record(0x00, 0);
+}
+
+/*
+ *  Queue the next request from `pages_done`, never across a section.
+ *  Returns false when everything has been copied.
+ *
+ *  A full queue is waited out here rather than reported, so false only
+ *  ever means done. From `step_done()` the finished request has just
+ *  left the queue, so the first try always gets its slot and the queue
+ *  is never polled from inside its own callback.
+ */
+static bool submit_next() {
+    size_t first = 0;
+
+    for(size_t i = 0; i < N_SECTIONS; i++) {
+        const copy_section_t *s = &sections[i];
+        size_t n = SECTION_PAGES(s);
+
+        if(pages_done < first+n) {
+            size_t page = pages_done - first;
+            size_t off = page*PW_EEPROM_PAGE_SIZE;
+            size_t len = PW_WALK_COPY_STEP_PAGES*PW_EEPROM_PAGE_SIZE;
+
+            if(len > s->size-off) len = s->size-off;
+            pages_req = (len + PW_EEPROM_PAGE_SIZE-1)/PW_EEPROM_PAGE_SIZE;
+
+            while(!pw_eeprom_async_copy(&req, s->dst+off, s->src+off, len, step_done, 0))
+                pw_eeprom_async_poll(0);
+            return true;
+        }
+        first += n;
+    }
+
+    return false;
+}
+
+/*
+ *  Data first, then the record that says it is there.
+ */
+static void step_done(pw_eeprom_req_t *r, void *ctx) {
+    (void)r;
+    (void)ctx;
+
+    pw_eeprom_cache_flush();
+
+    pages_done += pages_req;
+    if(submit_next()) {
+        save_record(PW_WALK_COPY_MARKER, pages_done);
+    } else {
+        finish();
+    }
+}
+
+void pw_walk_copy_begin() {
+    pw_walk_copy_wait();
+
+    pages_done = 0;
+    target_bank = !pw_eeprom_bank;
+
+    // marker must be on the eeprom before any data changes
+    save_record(PW_WALK_COPY_MARKER, 0);
+    if(!submit_next()) finish();
+}
+
+/*
+ *  Called at boot. Picks up a copy that didn't finish, returns true if
+ *  there was one.
+ */
+bool pw_walk_copy_resume() {
+    uint8_t record[PW_WALK_COPY_SIZE_RECORD];
+
+    if(pw_walk_copy_busy()) return true;
+
+    int r = pw_eeprom_reliable_read(
+                PW_EEPROM_ADDR_COPY_MARKER_1,
+                PW_EEPROM_ADDR_COPY_MARKER_2,
+                record,
+                PW_WALK_COPY_SIZE_RECORD
+            );
+    if(r < 0 || record[0] != PW_WALK_COPY_MARKER) return false;
+
+    pages_done = record[1] & ~PW_WALK_COPY_FLAG_BANK;
+    target_bank = (record[1] & PW_WALK_COPY_FLAG_BANK)?1:0;
+    if(!submit_next()) {
+        finish();
+        return false;
+    }
+
+    return true;
+}
+
+bool pw_walk_copy_busy() {
+    return pw_eeprom_async_pending(&req);
+}
+
+void pw_walk_copy_wait() {
+    pw_eeprom_async_wait(&req);
+}
@@ -0,0 +1,40 @@
+#ifndef PW_WALK_COPY_H
+#define PW_WALK_COPY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/// @file walk_copy.h
+
+/*
+ *  Walk start: copy the staged team data into place and make the staged
+ *  route live.
+ *
+ *  The copy runs in the background on the eeprom async queue, a few
+ *  pages per request. After each request has reached the eeprom the
+ *  copy record (marker, pages done and the bank to select, reliable
+ *  format, at the copy markers) is updated, so a copy cut short by a
+ *  reset carries on from there at the next boot. The route itself is not
+ *  copied, the last step flips the route bank (see eeprom_bank.h).
+ *
+ *      0xd480 team staging -> 0xcc00 team data, 548 bytes
+ *      0xdc00 peer team data -> the same in the live bank, 548 bytes
+ *      0xf400 peer sprite, name, data -> the same in the live bank, 760 bytes
+ *      select the bank holding 0xd700 scenario staging as 0x8f00
+ */
+
+#define PW_WALK_COPY_MARKER         0xa5
+#define PW_WALK_COPY_SIZE_RECORD    2       // marker, pages done (+ checksum = 3 bytes)
+#define PW_WALK_COPY_FLAG_BANK      0x80    // in pages done: bank to select at the end
+
+#ifndef PW_WALK_COPY_STEP_PAGES
+#define PW_WALK_COPY_STEP_PAGES     8       // pages per progress update
+#endif
+
+void pw_walk_copy_begin();
+bool pw_walk_copy_resume();
+bool pw_walk_copy_busy();
+void pw_walk_copy_wait();
+
+#endif /* PW_WALK_COPY_H */